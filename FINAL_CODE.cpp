@@ -11,6 +11,24 @@
 #include <queue>
 #include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <stdint.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <random>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
 #define nullptr NULL
 
 
@@ -223,21 +241,25 @@ Node* SplayTree::find(size_t position) {
     return _find(position, _root);
 }
 
+//descends iteratively: a splay tree over a long path can be as deep as the path itself
 Node* SplayTree::_find(size_t position, Node* vertex) {
-    Node::push(vertex);
-    
-    size_t indexLeft = Node::getSize(vertex->leftChild);
-    
-    if(position == indexLeft) {
-        splay(vertex);
-        return vertex;
-    }
-    
-    if(position < indexLeft) {
-        return _find(position, vertex->leftChild);
+    while(true) {
+        Node::push(vertex);
+        
+        size_t indexLeft = Node::getSize(vertex->leftChild);
+        
+        if(position == indexLeft) {
+            splay(vertex);
+            return vertex;
+        }
+        
+        if(position < indexLeft) {
+            vertex = vertex->leftChild;
+        } else {
+            position -= indexLeft + 1;
+            vertex = vertex->rightChild;
+        }
     }
-    
-    return _find(position - indexLeft - 1, vertex->rightChild);
 }
 
 std::pair<SplayTree*, SplayTree*> SplayTree::split(SplayTree* tree,size_t position) {
@@ -321,9 +343,9 @@ void SplayTree::_merge(SplayTree* addedTree) {
 
 //**********************************************************************************************
 class LinkCutTree {
-    friend class LinkCutBlockFlowFinder;
 private:
     std::vector <Node> nodes;
+    std::vector <Node*> _pushPath;   //ancestors waiting for push in _cleanUp, kept to avoid reallocation
     
     Node* _cutout(Node* vertex);
     Node* _leftest(Node* vertex);
@@ -403,16 +425,17 @@ Node* LinkCutTree::findRoot(size_t ind) {
     return _leftest(_liftUpToRoot(vertex));
 }
 
+//pushes removed weight from the splay root down to vertex, top-down, without recursion
 Node* LinkCutTree::_cleanUp(Node* vertex) {
-    Node* root;
-    
-    if(vertex->parent) {
-        root = _cleanUp(vertex->parent);
-    } else {
-        root = vertex;
+    _pushPath.clear();
+    for(;vertex; vertex = vertex->parent) {
+        _pushPath.push_back(vertex);
     }
     
-    Node::push(vertex);
+    Node* root = _pushPath.back();
+    for(size_t i = _pushPath.size();i > 0; --i) {
+        Node::push(_pushPath[i - 1]);
+    }
     
     return root;
 }
@@ -467,17 +490,17 @@ Node* LinkCutTree::getMinEdge(size_t ind) {
 }
 
 Node* LinkCutTree::_findLeftestMin(size_t minValue, Node* vertex) {
-    Node::push(vertex);
-    
-    if(Node::getMin(vertex->leftChild) == minValue) {
-        return _findLeftestMin(minValue, vertex->leftChild);
-    }
-    
-    if(vertex->edgeWeight == minValue) {
-        return vertex;
+    while(true) {
+        Node::push(vertex);
+        
+        if(Node::getMin(vertex->leftChild) == minValue) {
+            vertex = vertex->leftChild;
+        } else if(vertex->edgeWeight == minValue) {
+            return vertex;
+        } else {
+            vertex = vertex->rightChild;
+        }
     }
-    
-    return _findLeftestMin(minValue, vertex->rightChild);
 }
 
 void LinkCutTree::setWeight(size_t indVert, size_t weight) {
@@ -514,494 +537,5415 @@ class DirectEdge;
 class DinicFlowFinder;
 class BlockFlowFinder;
 class ShortPathNetwork;
-class LinkCutBlockFlowFinder;
+template <class DynamicTree> class DynamicTreeBlockFlowFinder;
+class DfsBlockFlowFinder;
+class LevelGraph;
+class MappedFile;
+class EdgeListParser;
+class ThreadPool;
+class MinCut;
+
+//width of vertex/edge numbers and of capacities in the flow graph. 32 bits halve the edge arrays;
+//build with -DGRAPH_INDEX_64 for more than 4G vertices or edges, -DGRAPH_CAPACITY_64 for capacities over 4G
+#ifdef GRAPH_INDEX_64
+typedef uint64_t IndexType;
+#else
+typedef uint32_t IndexType;
+#endif
+#ifdef GRAPH_CAPACITY_64
+typedef uint64_t CapacityType;
+#else
+typedef uint32_t CapacityType;
+#endif
+
+const IndexType UNREACHED = static_cast<IndexType>(-1); //distance of vertices the bfs didn't reach
 
 class DirectEdge
 {
 public:
-    size_t start; //points of directed edge
-    size_t finish;  //value of max flow for edge
-    size_t capacity;
+    IndexType start; //points of directed edge
+    IndexType finish;
+    CapacityType capacity;
+};
+
+//edges as separate columns, so hot loops only touch the fields they need
+class EdgeColumns
+{
+public:
+    vector <IndexType> start;
+    vector <IndexType> finish;
+    vector <CapacityType> capacity;
+    
+    size_t size() const { return start.size(); };
+    void resize(size_t sizeEdge) {
+        start.resize(sizeEdge);
+        finish.resize(sizeEdge);
+        capacity.resize(sizeEdge);
+    };
+    void push_back(const DirectEdge& edge) {
+        start.push_back(edge.start);
+        finish.push_back(edge.finish);
+        capacity.push_back(edge.capacity);
+    };
+    void swap(EdgeColumns& other) {
+        start.swap(other.start);
+        finish.swap(other.finish);
+        capacity.swap(other.capacity);
+    };
+};
+
+//read-only view of a whole file, mmapped where the platform allows it
+class MappedFile {
+private:
+    char* _data;
+    size_t _size;
+    bool _mapped;
+    vector <char> _buffer;  //fallback storage when the file can't be mapped
+public:
+    MappedFile();
+    ~MappedFile();
+    bool open(const char* path);
+    void close();
+    
+    const char* data() const { return _data; }; //read-only, the mapping is PROT_READ
+    size_t size() const { return _size; };
+};
+
+//fixed set of worker threads; run() calls job(threadIndex) once on every thread, the caller being thread 0
+class ThreadPool {
+private:
+    vector <std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _wakeUp;
+    std::condition_variable _finished;
+    const std::function<void(size_t)>* _job;
+    size_t _generation;
+    size_t _pending;
+    bool _stop;
+    void _workerLoop(size_t threadIndex);
+public:
+    ThreadPool(size_t threadCount);
+    ~ThreadPool();
+    size_t size() const { return _workers.size() + 1; };
+    void run(const std::function<void(size_t)>& job);
+    void parallelFor(size_t taskCount, const std::function<void(size_t, size_t)>& body); //body(task, threadIndex)
+};
+
+enum GraphFormat {
+    FORMAT_AUTO,
+    FORMAT_NATIVE,  //"V E" header, then E lines "start finish capacity"
+    FORMAT_DIMACS,  //"p max V E", "n id s|t", "a start finish capacity", "c" comments
+    FORMAT_BINARY   //see BinaryGraphHeader
+};
+
+GraphFormat detectGraphFormat(const char* data, size_t size);
+
+//parses the native or the DIMACS text format straight from raw bytes
+class EdgeListParser {
+private:
+    const char* _begin;
+    const char* _pos;
+    const char* _end;
+    GraphFormat _format;
+    void _skipBlank(); //whitespace, and comment lines in DIMACS
+    void _skipLine();
+    void _skipSpaces(); //whitespace up to the end of the line
+    bool _readNumber(size_t& value); //sets error only on overflow, callers name what they expected otherwise
+    bool _readNumberInLine(size_t& value);
+    bool _parseNativeHeader(size_t& sizeVert, size_t& sizeEdge);
+    bool _parseDimacsHeader(size_t& sizeVert, size_t& sizeEdge);
+    bool _readEdge(size_t sizeVert, EdgeColumns& edges, size_t index);
+    bool _readEdges(size_t sizeVert, EdgeColumns& edges, size_t first, size_t edgeCount);
+public:
+    static size_t countEdgeLines(const char* begin, const char* end, GraphFormat format);
+    const char* error;
+    size_t source;  //terminals declared by the input, 0 and V - 1 for the native format
+    size_t sink;
+    EdgeListParser(const char* begin, const char* end, GraphFormat format);
+    bool parseHeader(size_t& sizeVert, size_t& sizeEdge);
+    bool readPair(size_t& first, size_t& second); //false at the end of input, or with error set
+    bool parse(size_t& sizeVert, EdgeColumns& edges);
+    bool parseParallel(ThreadPool& pool, size_t& sizeVert, EdgeColumns& edges); //keeps input order of edges
+    size_t errorOffset() const { return _pos - _begin; };
+};
+
+struct LoadStats {
+    size_t bytes;
+    size_t threads;
+    double seconds;
+    double megabytesPerSecond() const { return seconds > 0 ? bytes / seconds / (1 << 20) : 0; };
+};
+
+//non-owning pointer + length, so graph arrays can live in a vector or in a mapped file
+template <class T>
+class ArrayView
+{
+private:
+    T* _data;
+    size_t _size;
+public:
+    ArrayView(): _data(nullptr), _size(0) {};
+    ArrayView(T* data, size_t size): _data(data), _size(size) {};
+    
+    T& operator[](size_t index) const { return _data[index]; };
+    size_t size() const { return _size; };
+    bool empty() const { return _size == 0; };
+    T* begin() const { return _data; };
+    T* end() const { return _data + _size; };
+};
+
+//compressed sparse rows: edges of vertex v are edgeIds[offsets[v]] .. edgeIds[offsets[v + 1] - 1]
+class AdjacencyList
+{
+public:
+    ArrayView <const IndexType> offsets;
+    ArrayView <const IndexType> edgeIds;
+    
+    size_t degree(size_t vert) const { return offsets[vert + 1] - offsets[vert]; };
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; };
 };
 
 class Graph
 {
+private:
+    EdgeColumns _edgeStorage;
+    vector <IndexType> _adjacencyStorage; //both offset arrays and both edge id arrays back to back
+    MappedFile* _mapping;  //set when the arrays point into a mapped binary graph file
+    
+    void _bindEdgeStorage();
+    void _bindAdjacency(const IndexType* adjacency);
+    void _buildAdjacency();
 public:
-    vector <vector <size_t> >& outgoingList; //lists of numbers of edges that outgoing and incoming in vertex
-    vector <vector <size_t> >& incomingList;
-    vector <DirectEdge>& edgeList; //full info about edge
+    AdjacencyList outgoingList; //lists of numbers of edges that outgoing and incoming in vertex
+    AdjacencyList incomingList;
+    ArrayView <const IndexType> edgeStart; //points of directed edge; read-only, a binary graph maps them read-only
+    ArrayView <const IndexType> edgeFinish;
+    ArrayView <const CapacityType> edgeCapacity;
     size_t sizeVert; //total quantity of verticies and edges
     size_t sizeEdge;
-    Graph(size_t vertices, vector <DirectEdge>& edges);  //get graph from list pairs of vertices
+    size_t declaredSource; //terminals named by the input file, 0 and V - 1 unless it says otherwise
+    size_t declaredSink;
+    Graph(size_t vertices, EdgeColumns& edges);  //takes over the storage of edges, leaving it empty
+    Graph(size_t vertices, vector <DirectEdge>& edges); //copies edges into columns and frees them
+    Graph(MappedFile* mapping); //adopts a mapped binary graph file, arrays are used in place
+    
+    DirectEdge edge(size_t edgeNumber) const;
+    size_t memoryBytes() const; //edge columns and adjacency, mapped or not
+    CapacityType* writableCapacity() { //of a graph built in memory, like a short path network; never of a mapped one
+        assert(!_mapping);
+        return sizeEdge ? &_edgeStorage.capacity[0] : nullptr;
+    };
     
     ~Graph();
 };
 
+//binary graph file: header, edge columns, outgoing offsets and ids, incoming offsets and ids
+struct BinaryGraphHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;  //BINARY_GRAPH_BYTE_ORDER as written by the producing machine
+    uint32_t indexBytes; //sizeof(IndexType) and sizeof(CapacityType) of the producing build
+    uint32_t capacityBytes;
+    uint64_t sizeVert;
+    uint64_t sizeEdge;
+    uint64_t source;
+    uint64_t sink;
+};
+
+const char BINARY_GRAPH_MAGIC[8] = {'D', 'I', 'N', 'I', 'C', 'G', 'R', 0};
+const uint32_t BINARY_GRAPH_VERSION = 3;
+const uint32_t BINARY_GRAPH_BYTE_ORDER = 0x01020304;
+
+size_t peakMemoryKilobytes();
+double secondsSince(std::chrono::steady_clock::time_point startTime);
+bool isBinaryGraph(const char* data, size_t size);
+bool writeBinaryGraph(const char* path, Graph& graph);
+const char* checkBinaryGraph(const Graph& graph); //first inconsistency of a mapped graph, nullptr if there is none
+
+//formats text into a large buffer and hands it to the file in few big writes
+class BulkWriter {
+private:
+    FILE* _file;
+    vector <char> _buffer;
+    size_t _used;
+    bool _failed;
+public:
+    BulkWriter(FILE* file, size_t bufferBytes = 1 << 22);
+    ~BulkWriter();
+    
+    static char* formatNumber(char* out, unsigned long long value); //returns the end of the digits
+    
+    void write(const char* data, size_t size);
+    void writeNumber(unsigned long long value);
+    void writeChar(char symbol);
+    bool flush();
+    
+    //formatLine(out, index) writes line index at out and returns its end; at most maxLineBytes per line.
+    //Blocks of lines are formatted in parallel on pool and written in order.
+    template <class LineFormatter>
+    bool writeLines(size_t lineCount, size_t maxLineBytes, ThreadPool* pool, LineFormatter formatLine);
+};
+
+template <class LineFormatter>
+bool BulkWriter::writeLines(size_t lineCount, size_t maxLineBytes, ThreadPool* pool, LineFormatter formatLine) {
+    size_t threads = pool ? pool->size() : 1;
+    const size_t linesPerBlock = max(static_cast<size_t>(1), min(static_cast<size_t>(1 << 18), (lineCount + threads - 1) / threads));
+    vector <vector <char> > blocks(threads, vector <char>(linesPerBlock * maxLineBytes));
+    vector <size_t> blockBytes(threads);
+    
+    flush();
+    for(size_t first = 0;first < lineCount; first += threads * linesPerBlock) {
+        std::function<void(size_t, size_t)> formatBlock = [&](size_t block, size_t) {
+            size_t begin = min(lineCount, first + block * linesPerBlock);
+            size_t end = min(lineCount, begin + linesPerBlock);
+            char* out = &blocks[block][0];
+            for(size_t i = begin;i < end; ++i) {
+                out = formatLine(out, i);
+            }
+            blockBytes[block] = out - &blocks[block][0];
+        };
+        if(pool) {
+            pool->parallelFor(threads, formatBlock);
+        } else {
+            formatBlock(0, 0);
+        }
+        for(size_t block = 0;block < threads; ++block) {
+            _failed = _failed || fwrite(&blocks[block][0], 1, blockBytes[block], _file) != blockBytes[block];
+        }
+    }
+    return !_failed;
+}
+
+bool writeDimacsFlow(const char* path, Network& network, ThreadPool* pool); //"s value" and one "f start finish flow" line per edge
+bool writeFlowText(const char* path, Network& network, ThreadPool* pool); //flow of every edge, one per line, in input order
+bool writeFlowBinary(const char* path, Network& network); //the raw flow array, CapacityType in host byte order
+bool writeMinCut(const char* path, Network& network, MinCut& cut); //"v vertex" and "e edge start finish capacity" lines
+//format FORMAT_AUTO detects it, pool parses text in parallel
+Graph* loadGraphFile(const char* path, LoadStats* stats, ThreadPool* pool = nullptr, GraphFormat format = FORMAT_AUTO);
+
 class Network
 {
 public:
     long long maxFlow;
-    vector <size_t> flow;  //current flow in each edge
+    vector <CapacityType> flow;  //current flow in each edge
     size_t source;    //source and sink in Network
     size_t sink;
     Graph *graph;
     Network(Graph *graph, size_t source, size_t sink);
     ~Network();
     size_t getMaxFlow(FlowFinder& flowFinder);   //workfunction
+    void reset(size_t source, size_t sink);  //zero flow for a new query on the same graph
     
 };
 
+//both modes give the same dist, they differ only in the edges they look at
+enum BfsMode {
+    BFS_TOP_DOWN,   //queue of vertices, every residual edge of a visited vertex is looked at
+    BFS_HYBRID,     //level by level, large frontiers are expanded bottom-up: unvisited vertices look for a parent
+    BFS_PARALLEL    //BFS_HYBRID with every level split between the threads of Bfs::pool
+};
+
 class Bfs{
 public:
     Bfs();
     ~Bfs();
     vector <bool>* used;
-    vector <size_t>* dist;
+    vector <IndexType>* dist;
     
-    queue <pair <size_t, size_t> > bfsQueue;
+    queue <pair <IndexType, IndexType> > bfsQueue;
+    vector <IndexType> frontier;
+    vector <IndexType> nextFrontier;
+    vector <vector <IndexType> > threadFrontiers; //next frontier parts found by each thread in BFS_PARALLEL
+    vector <uint64_t> visitedBits;                 //visited vertices of BFS_PARALLEL, claimed by atomic or
+    ThreadPool* pool;
     
     Graph* graph;
     
     size_t source;
     size_t sink;
-    DirectEdge curEdge;
     
     Network* network;
+    BfsMode mode;
+    size_t edgesExamined; //by the last run
+    bool stopAtSinkLevel; //don't expand the level of the sink, later vertices stay UNREACHED
+    CapacityType minResidual; //residual edges with less capacity are left out, 1 unless capacity scaling
+    vector <bool> onShortestPath;
+    
     void init(Network* network);
     void checkOutgoingEdges(size_t vert, size_t leveldist);
     void checkIncomingEdges(size_t vert, size_t levelDist);
     
+    size_t degree(size_t vert) const {
+        return graph->outgoingList.degree(vert) + graph->incomingList.degree(vert);
+    };
+    void visit(IndexType vert, IndexType levelDist, size_t& frontierEdges);
+    size_t topDownStep(IndexType level);  //all steps return the edge count of the next frontier
+    size_t bottomUpStep(IndexType level);
+    bool hasParent(IndexType vert, IndexType level, size_t& examined);
+    bool isUnreached(IndexType vert) const {
+        return !(__atomic_load_n(&visitedBits[vert >> 6], __ATOMIC_RELAXED) & (static_cast<uint64_t>(1) << (vert & 63)));
+    };
+    bool claim(IndexType vert, IndexType levelDist);
+    size_t parallelTopDownStep(IndexType level);
+    size_t parallelBottomUpStep(IndexType level);
+    size_t gatherNextFrontier();
+    bool runHybrid();
+    
     bool run();//return true if sink is available from source
+    void pruneDeadEnds();
+};
+
+//source side of a minimum cut and the saturated edges leaving it
+class MinCut {
+public:
+    vector <bool> sourceSide;
+    vector <IndexType> sourceVertices;
+    vector <IndexType> cutEdges;
+    long long capacity;
+    void build(Network* network, const vector <bool>& reachable); //reachable: residual reachability from source
 };
 
 class FlowFinder {
 public:
     long long maxFlow;
     Network* network;
-    //virtual ~FlowFinder() = 0;
+    virtual ~FlowFinder() {};
     virtual void initFlowFinder(Network* network) = 0;
     virtual void getMaxFlow() = 0;
+    virtual void getMinCut(MinCut& cut); //after getMaxFlow; default runs one residual bfs
+};
+
+//residual graph of a network as a view of the network itself, nothing is copied: the arcs of a vertex are its
+//outgoing edges (forward, residual capacity - flow) and then its incoming edges (backward, residual flow), numbered
+//by position, outgoing positions first and incoming ones shifted by E
+class ResidualGraph {
+public:
+    Network* network;
+    Graph* graph;
+    CapacityType* flow;
+    
+    void init(Network* network) {
+        this->network = network;
+        graph = network->graph;
+        flow = &network->flow[0];
+    };
+    
+    size_t arcEnd(size_t vert) const { return graph->sizeEdge + graph->incomingList.offsets[vert + 1]; };
+    size_t firstArc(size_t vert) const {
+        size_t arc = graph->outgoingList.offsets[vert];
+        return arc != graph->outgoingList.offsets[vert + 1] ? arc : graph->sizeEdge + graph->incomingList.offsets[vert];
+    };
+    void nextArc(size_t vert, size_t& arc) const {
+        if(++arc == graph->outgoingList.offsets[vert + 1]) {
+            arc = graph->sizeEdge + graph->incomingList.offsets[vert];
+        }
+    };
+    
+    bool isForward(size_t arc) const { return arc < graph->sizeEdge; };
+    IndexType arcEdge(size_t arc) const {
+        return isForward(arc) ? graph->outgoingList.edgeIds[arc] : graph->incomingList.edgeIds[arc - graph->sizeEdge];
+    };
+    IndexType arcHead(size_t arc) const {
+        return isForward(arc) ? graph->edgeFinish[arcEdge(arc)] : graph->edgeStart[arcEdge(arc)];
+    };
+    CapacityType arcResidual(size_t arc) const {
+        IndexType edge = arcEdge(arc);
+        return isForward(arc) ? graph->edgeCapacity[edge] - flow[edge] : flow[edge];
+    };
+    CapacityType reverseResidual(size_t arc) const { //of the arc from the head back to the vertex
+        IndexType edge = arcEdge(arc);
+        return isForward(arc) ? flow[edge] : graph->edgeCapacity[edge] - flow[edge];
+    };
+    void pushFlow(size_t arc, CapacityType value) {
+        if(isForward(arc)) {
+            flow[arcEdge(arc)] += value;
+        } else {
+            flow[arcEdge(arc)] -= value;
+        }
+    };
+    //relaxed atomic variants for arcs that one thread pushes along while the vertex at the other end reads them
+    CapacityType sharedArcResidual(size_t arc) const {
+        IndexType edge = arcEdge(arc);
+        CapacityType edgeFlow = __atomic_load_n(&flow[edge], __ATOMIC_RELAXED);
+        return isForward(arc) ? graph->edgeCapacity[edge] - edgeFlow : edgeFlow;
+    };
+    void sharedPushFlow(size_t arc, CapacityType value) { //the caller must be the only writer of the arc
+        IndexType edge = arcEdge(arc);
+        CapacityType edgeFlow = __atomic_load_n(&flow[edge], __ATOMIC_RELAXED);
+        __atomic_store_n(&flow[edge], isForward(arc) ? edgeFlow + value : edgeFlow - value, __ATOMIC_RELAXED);
+    };
+    long long netOutflow(size_t vert) const { //self-loops left out
+        long long outflow = 0;
+        for(size_t arc = firstArc(vert);arc != arcEnd(vert); nextArc(vert, arc)) {
+            if(arcHead(arc) != vert) {
+                outflow += isForward(arc) ? flow[arcEdge(arc)] : -static_cast<long long>(flow[arcEdge(arc)]);
+            }
+        }
+        return outflow;
+    };
+};
+
+//level graph of a Dinic phase: an arc of the residual graph is usable if it has residual capacity, leads one bfs
+//level up and doesn't leave the sink; with capacity scaling, a residual capacity of minResidual.
+class LevelGraph : public ResidualGraph {
+public:
+    const IndexType* dist;
+    CapacityType minResidual;
+    
+    void init(Network* network, const vector <IndexType>& dist, CapacityType minResidual) {
+        ResidualGraph::init(network);
+        this->dist = &dist[0];
+        this->minResidual = minResidual;
+    };
+    
+    //moves arc forward to the first usable one, false if the vertex has none left
+    bool findUsableArc(size_t vert, size_t& arc) const {
+        if(vert == network->sink) {
+            return false;
+        }
+        size_t end = arcEnd(vert);
+        IndexType nextLevel = dist[vert] + 1;
+        for(;arc != end; nextArc(vert, arc)) {
+            if(dist[arcHead(arc)] == nextLevel && arcResidual(arc) >= minResidual) {
+                return true;
+            }
+        }
+        return false;
+    };
 };
 
 class DinicFlowFinder : public FlowFinder {
 private:
     ShortPathNetwork* shortPathNetwork;
     BlockFlowFinder* blockFlowFinder;
+    LevelGraph levelGraph;
+    bool useLevelGraphView;
 public:
-    DinicFlowFinder(BlockFlowFinder* blockFlowFinder);
+    //useLevelGraphView: run blocking flows on a LevelGraph view instead of a copied ShortPathNetwork per phase
+    DinicFlowFinder(BlockFlowFinder* blockFlowFinder, bool useLevelGraphView = true);
     ~DinicFlowFinder();
     void getMaxFlow();
+    void runPhases();
+    void getMinCut(MinCut& cut); //reuses the last bfs, which found the sink unreachable
     void updateFlow();
     void calcMaxFlow();
     void initFlowFinder(Network* network);
+    bool runLevelBfs();
+    size_t countAdmissibleArcs();
     bool getShortPathNetwork();
+    bool getLevelGraph();
     bool checkEdgeForShortPath(size_t edgeNumber, DirectEdge& edge);
     Bfs bfs;
+    size_t phaseCount;        //of the last getMaxFlow
+    size_t bfsEdgesExamined;  //summed over its phases
+    bool pruneLevelGraph;     //keep only vertices on shortest paths to the sink, default on
+    bool countLevelArcs;      //fill levelArcCounts, costs a pass over the edges per phase
+    vector <size_t> levelArcCounts; //arcs of the level graph of each phase of the last getMaxFlow
+    CapacityType minResidual; //phases only use residual edges of at least this capacity
+};
+
+//Dinic with capacity scaling: rounds of phases over residual edges of at least delta, delta going from the
+//largest power of two up to the largest capacity down to 1. A round blocks all paths of wide edges, so
+//large capacities are pushed in few phases before the narrow edges are looked at
+CapacityType largestPowerOfTwo(CapacityType limit); //0 for 0
+
+class ScalingDinicFlowFinder : public DinicFlowFinder {
+public:
+    ScalingDinicFlowFinder(BlockFlowFinder* blockFlowFinder, bool useLevelGraphView = true);
+    void getMaxFlow();
+    CapacityType maxLeavingResidual();
+    size_t roundCount;
+};
+
+//push-relabel with highest-label selection. The first phase pushes excess towards the sink until no vertex that
+//can still reach it has excess: then the excess of the sink is the max flow and the vertices that can't reach the
+//sink are the source side of a min cut. The second phase returns the remaining excess to the source, so that the
+//preflow becomes a flow. Labels are kept exact by global relabels (reverse bfs from the sink, or the source in the
+//second phase) after every 6V + E units of relabel work, and by the gap heuristic: when no vertex is left with
+//some label, every vertex above it is cut off and gets label V
+class PushRelabelFlowFinder : public FlowFinder {
+protected:
+    ResidualGraph _residual;
+    vector <long long> _excess;
+    vector <IndexType> _label;
+    vector <size_t> _curArc;
+    //per label: active vertices (singly linked) and all vertices below V (doubly linked, for the gap heuristic)
+    vector <IndexType> _activeHead;
+    vector <IndexType> _nextActive;
+    vector <IndexType> _bucketHead;
+    vector <IndexType> _nextInBucket;
+    vector <IndexType> _prevInBucket;
+    IndexType _maxActive;
+    IndexType _maxLabel;
+    size_t _target;       //the sink in the first phase, the source in the second
+    size_t _otherTerminal;
+    size_t _workSinceGlobalRelabel;
+    vector <bool> _sourceSide;
+    
+    void _addActive(IndexType vert);
+    void _addToBucket(IndexType vert);
+    void _removeFromBucket(IndexType vert);
+    void _globalRelabel();
+    void _gap(IndexType emptyLabel);
+    void _relabel(IndexType vert);
+    void _discharge(IndexType vert);
+    void _runPhase(size_t target, size_t otherTerminal);
+    virtual void _runFirstPhase();
+public:
+    PushRelabelFlowFinder();
+    bool minCutOnly;    //stop after the first phase: maxFlow and the min cut are known, network->flow is a preflow
+    size_t pushCount;
+    size_t relabelCount;
+    size_t globalRelabelCount;
+    size_t gapCount;
+    
+    void initFlowFinder(Network* network);
+    void getMaxFlow();
+    void getMinCut(MinCut& cut);
+};
+
+//push-relabel whose first phase runs on a thread pool, in the synchronous rounds of Baumstark, Blelloch and Shun:
+//every round discharges the whole working set (the active vertices) in parallel against the labels of the round
+//start, and new labels and received excess only take effect after it. When two working vertices are neighbours,
+//only the winner of the pair may use the arcs between them, so each edge has one writer per round; excess sent to
+//other vertices is added atomically. Blocks of the working set are handed out on demand to balance the threads.
+//Global relabels are parallel level-synchronous reverse bfs runs; the second phase is the serial one.
+//The rounds stand in for an asynchronous concurrent active-vertex queue with work stealing on purpose: the barrier
+//between rounds is what makes the labels a vertex reads consistent without locking vertices, and claiming blocks
+//from the shared counter balances the threads the way stealing would
+class ParallelPushRelabelFlowFinder : public PushRelabelFlowFinder {
+private:
+    ThreadPool* _pool;
+    vector <IndexType> _working;
+    vector <IndexType> _newLabel;
+    vector <long long> _addedExcess;
+    vector <uint32_t> _workingRound;    //round in which a vertex was in the working set
+    vector <uint32_t> _discoveredRound; //round in which a vertex got its first excess
+    vector <vector <IndexType> > _threadLists;
+    uint32_t _round;
+    
+    bool _wins(IndexType vert, IndexType nextVert) const;
+    size_t _parallelDischarge(IndexType vert, vector <IndexType>& discovered, size_t& pushes); //returns the work done
+    void _parallelGlobalRelabel();
+    void _gatherThreadLists(vector <IndexType>& list);
+    void _runFirstPhase();
+public:
+    ParallelPushRelabelFlowFinder(ThreadPool* pool);
+    size_t roundCount;
+};
+
+//Boykov-Kolmogorov: a search tree grows from the source and one from the sink over residual arcs, the active
+//vertices (FIFO) on their fronts adopting free neighbours, until an arc joins the two trees into an augmenting path.
+//The trees are kept between augmentations: a saturated tree arc orphans its child, and an orphan takes as parent
+//the neighbour of its tree closest to the root (distances are cached with the augmentation they were found in),
+//or is freed and orphans its children. Fast on shallow graphs such as grids with terminal edges at every pixel
+const IndexType NO_PARENT = UNREACHED;           //parent edge of free vertices and orphans
+const IndexType TERMINAL_PARENT = UNREACHED - 1; //parent edge of the source and the sink
+
+class BoykovKolmogorovFlowFinder : public FlowFinder {
+private:
+    enum Tree {
+        TREE_FREE,
+        TREE_SOURCE,
+        TREE_SINK
+    };
+    ResidualGraph _residual;
+    vector <char> _tree;
+    vector <IndexType> _parentEdge;
+    vector <IndexType> _dist;       //tree edges to the root, known to be exact in augmentation _timestamp
+    vector <size_t> _timestamp;
+    vector <size_t> _curArc;        //the growth of an active vertex goes on from here
+    vector <IndexType> _nextActive; //UNREACHED for vertices outside the queue, the last one points to itself
+    IndexType _firstActive;
+    IndexType _lastActive;
+    vector <IndexType> _orphans;
+    size_t _time;                   //augmentations so far
+    vector <bool> _sourceSide;
+    
+    IndexType _parent(IndexType vert) const {
+        IndexType edge = _parentEdge[vert];
+        return network->graph->edgeStart[edge] == vert ? network->graph->edgeFinish[edge] : network->graph->edgeStart[edge];
+    };
+    CapacityType _residualFrom(IndexType vert, IndexType edge) const { //over edge to its other end
+        return network->graph->edgeStart[edge] == vert ? network->graph->edgeCapacity[edge] - _residual.flow[edge] : _residual.flow[edge];
+    };
+    void _pushFrom(IndexType vert, IndexType edge, CapacityType value) {
+        if(network->graph->edgeStart[edge] == vert) {
+            _residual.flow[edge] += value;
+        } else {
+            _residual.flow[edge] -= value;
+        }
+    };
+    void _setActive(IndexType vert);
+    IndexType _popActive();
+    size_t _grow(IndexType vert); //arc to the other tree, arcEnd(vert) when vert has no free or other tree neighbours left
+    void _augment(IndexType vert, size_t arc);
+    void _orphan(IndexType vert);
+    IndexType _rootDist(IndexType vert); //UNREACHED if the tree path of vert ends in an orphan
+    void _adopt(IndexType orphan);
+public:
+    BoykovKolmogorovFlowFinder();
+    size_t augmentationCount;
+    size_t orphanCount;
+    
+    void initFlowFinder(Network* network);
+    void getMaxFlow();
+    void getMinCut(MinCut& cut); //the source tree, which is the residual reachability from the source
+};
+
+//Hochbaum's pseudoflow, lowest label variant. Every arc out of the source and into the sink starts saturated, which
+//leaves excesses and deficits at the other vertices; those are kept in a forest whose arcs have residual capacity
+//towards the roots, a tree being strong when its root has excess. The strong root of lowest label L is processed:
+//its vertices of label L look for a residual arc to a vertex of label L - 1, which is weak. Such a merger arc hangs
+//the strong tree below the weak vertex and its excess is pushed to the weak root, splitting off the subtree below
+//every arc that saturates. Vertices without a merger arc are relabeled, and a strong tree with no vertex left at
+//the label below its root can't reach a deficit any more and is lifted to V. Labels never drop towards the leaves
+//of a tree. In the end the strong vertices are the source side of a min cut, and the excesses go back to the
+//source and the deficits to the sink so that network->flow is a flow
+class PseudoflowFlowFinder : public FlowFinder {
+private:
+    ResidualGraph _residual;
+    vector <long long> _excess;
+    vector <IndexType> _label;
+    vector <size_t> _labelCount;
+    vector <size_t> _curArc;
+    vector <IndexType> _parent;     //UNREACHED for roots
+    vector <IndexType> _parentEdge;
+    vector <IndexType> _firstChild;  //children doubly linked, so a split is O(1)
+    vector <IndexType> _nextSibling;
+    vector <IndexType> _prevSibling;
+    vector <IndexType> _nextScan;    //next child of the depth-first search of processRoot
+    vector <IndexType> _rootHead;    //strong roots per label, singly linked
+    vector <IndexType> _nextRoot;
+    IndexType _lowestLabel;
+    vector <IndexType> _stack;
+    vector <bool> _sourceSide;
+    
+    CapacityType _residualFrom(IndexType vert, IndexType edge) const {
+        return network->graph->edgeStart[edge] == vert ? network->graph->edgeCapacity[edge] - _residual.flow[edge] : _residual.flow[edge];
+    };
+    void _pushFrom(IndexType vert, IndexType edge, CapacityType value) {
+        if(network->graph->edgeStart[edge] == vert) {
+            _residual.flow[edge] += value;
+        } else {
+            _residual.flow[edge] -= value;
+        }
+    };
+    void _addStrongRoot(IndexType vert);
+    void _addChild(IndexType parent, IndexType child, IndexType edge);
+    void _removeChild(IndexType child);
+    void _setLabel(IndexType vert, IndexType label);
+    bool _findMerger(IndexType vert, size_t& arc);
+    void _checkChildren(IndexType vert);
+    void _merge(IndexType root, IndexType strongVert, size_t arc);
+    void _pushExcess(IndexType root);
+    void _processRoot(IndexType root);
+    void _liftAll(IndexType root);
+    void _returnExcess(); //turns the pseudoflow into a flow of the same value
+public:
+    PseudoflowFlowFinder();
+    size_t mergeCount;
+    size_t relabelCount;
+    size_t liftCount;
+    
+    void initFlowFinder(Network* network);
+    void getMaxFlow();
+    void getMinCut(MinCut& cut);
+};
+
+//Dinic for graphs whose capacities are all equal (unit capacities, up to a common factor). Every edge is empty or
+//full, so the residual state is one bit per edge and a path always carries one unit and saturates all of its arcs.
+//Levels are residual distances to the sink, from a reverse bfs that stops at the level of the source, so the dfs
+//from the source only enters vertices with a shortest path on to the sink; it keeps current arcs and deletes the
+//dead ends that saturation leaves (their level is dropped). O(E sqrt(E)) in general and O(E sqrt(V)) when every
+//vertex has one incoming or one outgoing edge, as in matchings
+CapacityType uniformCapacity(Graph* graph); //the capacity of every edge, 0 if they differ or there are no edges
+
+class UnitCapacityFlowFinder : public FlowFinder {
+private:
+    ResidualGraph _residual;
+    vector <uint64_t> _full;  //bit per edge, set when it carries the capacity
+    vector <IndexType> _dist;
+    vector <IndexType> _queue;
+    vector <size_t> _curArc;
+    vector <size_t> _path;
+    CapacityType _capacity;
+    
+    bool _isFull(IndexType edge) const { return (_full[edge >> 6] >> (edge & 63)) & 1; };
+    bool _isUsable(size_t arc) const { return _residual.isForward(arc) != _isFull(_residual.arcEdge(arc)); };
+    bool _isReverseUsable(size_t arc) const { return _residual.isForward(arc) == _isFull(_residual.arcEdge(arc)); };
+    void _flip(size_t arc) {
+        IndexType edge = _residual.arcEdge(arc);
+        _full[edge >> 6] ^= static_cast<uint64_t>(1) << (edge & 63);
+    };
+    bool _runBfs();
+    size_t _findBlockFlow(); //returns the paths found
+public:
+    UnitCapacityFlowFinder();
+    size_t phaseCount;
+    
+    void initFlowFinder(Network* network);
+    void getMaxFlow();
+    void getMinCut(MinCut& cut); //the vertices that can't reach the sink in the last bfs
 };
 
 class ShortPathNetwork : public Network{
 public:
-    vector <size_t>& edgeID;
-    ShortPathNetwork(Graph* graph, size_t source, size_t sink, vector<size_t>& edgeID);
+    vector <IndexType>& edgeID;
+    ShortPathNetwork(Graph* graph, size_t source, size_t sink, vector<IndexType>& edgeID);
     ~ShortPathNetwork();
     void updateShortPathNetwork();
 };
 
+const IndexType NO_NODE = UNREACHED; //missing child or parent in AccessLinkCutTree
+
+//vertex of AccessLinkCutTree, only what a rotation reads and writes: 32-bit links and the three weights, 40 bytes.
+//The weight stays next to the links since _update of the lowered vertex reads it on every rotation; key fills
+//the padding and makes the returned vertices usable like Node
+class LinkCutNode {
+public:
+    IndexType leftChild;
+    IndexType rightChild;
+    IndexType parent;   //splay parent inside a preferred path, path-parent at the root of a splay tree
+    IndexType key;
+    size_t subtreeMinWeight;
+    size_t removedWeightValue;
+    size_t edgeWeight;
+};
+
+//the same forest as LinkCutTree on the classic path-parent representation, left is closer to the tree root.
+//Paths are joined in _access by rewiring right children, so no SplayTree objects, no allocation after the
+//constructor. Vertices live in one pool of LinkCutNode indexed by vertex number. clearTrees only starts a new
+//epoch, a vertex is reset when a public operation first names it in the epoch; links are made between named
+//vertices only, so everything reachable from a named vertex is current too
+class AccessLinkCutTree {
+private:
+    vector <LinkCutNode> nodes;
+    vector <IndexType> _epoch;      //epoch of the last reset of each vertex, cold: read once per public operation
+    IndexType _currentEpoch;
+    vector <IndexType> _pushPath;   //splay path waiting for push, reserved for the deepest possible path
+    
+    void _touch(IndexType vertex);
+    size_t _getMin(IndexType vertex) const;
+    bool _isSplayRoot(IndexType vertex) const;
+    void _update(IndexType vertex);
+    void _push(IndexType vertex);
+    void _rotate(IndexType vertex);
+    void _splay(IndexType vertex);
+    void _access(IndexType vertex);
+    IndexType _leftest(IndexType vertex);   //splays the leftmost vertex of the splay tree of vertex
+public:
+    size_t rotationCount;
+    
+    AccessLinkCutTree(size_t sizeVert);
+    
+    void clearTrees();
+    size_t memoryBytes() const;
+    
+    void removeWeightInPath(size_t weight, size_t ind);
+    void link(size_t indRoot, size_t indVert);
+    void cut(size_t indVert, size_t indParent);
+    void setWeight(size_t indVert, size_t weight);
+    
+    size_t getEdgeWeight(size_t indVert);
+    LinkCutNode* prevInPath(size_t ind);
+    LinkCutNode* getMinEdge(size_t ind);
+    LinkCutNode* findRoot(size_t ind);
+};
+
 class BlockFlowFinder {
 public:
-    //virtual ~BlockFlowFinder() = 0;
+    virtual ~BlockFlowFinder() {};
     ShortPathNetwork* shortPathNetwork;
     virtual void findBlockFlow() = 0;
+    virtual void findBlockFlow(LevelGraph& levelGraph) = 0; //pushes the blocking flow straight into the network
 };
 
-class LinkCutBlockFlowFinder : public BlockFlowFinder {
+//blocking flow by dynamic trees, DynamicTree is AccessLinkCutTree or the split and merge based LinkCutTree
+template <class DynamicTree>
+class DynamicTreeBlockFlowFinder : public BlockFlowFinder {
 private:
     //ShortPathNetwork* shortPathNetwork;
-    vector <size_t> curEdgeNumber;
+    vector <size_t> curEdgeNumber; //current arc of each vertex, a position in outgoingList.edgeIds
     vector <bool> edgeInsideTreeFlag;
-    void addEdge(size_t vertex, size_t nextVert, vector <vector <size_t> >& outEdges, vector <DirectEdge>& edgeList);
-    void removeEdge(size_t vertex, size_t prevVert, vector <vector <size_t> >& outEdges, vector <DirectEdge>& edgeList);
-    void decreaseWeightsInPath(Node* minEdge, vector <vector <size_t> >& outEdges, vector <DirectEdge>& edgeList);
-    void updateBlockFlow(vector <size_t>& flow, vector <vector <size_t> >& outEdges, vector <DirectEdge>& edgeList);
-    LinkCutTree linkCut;
+    void addEdge(size_t vertex, size_t nextVert, AdjacencyList& outEdges, Graph* graph);
+    void removeEdge(size_t vertex, size_t prevVert, AdjacencyList& outEdges, Graph* graph);
+    void decreaseWeightsInPath(size_t minWeight, AdjacencyList& outEdges, Graph* graph);
+    void updateBlockFlow(vector <CapacityType>& flow, AdjacencyList& outEdges, Graph* graph);
+    
+    vector <size_t> curArc; //current arc of each vertex in a LevelGraph
+    void addArc(size_t vertex, size_t nextVert, LevelGraph& levelGraph);
+    void removeArc(size_t vertex, size_t prevVert, LevelGraph& levelGraph);
+    void decreaseWeightsInPath(size_t minWeight, LevelGraph& levelGraph);
+    
+    DynamicTree linkCut;
     size_t source;
     size_t sink;
 public:
-    LinkCutBlockFlowFinder(size_t sizeVert, size_t source, size_t sink);
-    ~LinkCutBlockFlowFinder();
+    DynamicTreeBlockFlowFinder(size_t sizeVert, size_t source, size_t sink);
+    ~DynamicTreeBlockFlowFinder();
     void findBlockFlow();
+    void findBlockFlow(LevelGraph& levelGraph);
 };
 
+typedef DynamicTreeBlockFlowFinder <AccessLinkCutTree> LinkCutBlockFlowFinder;
+typedef DynamicTreeBlockFlowFinder <LinkCutTree> SplitLinkCutBlockFlowFinder;
+
+//blocking flow by depth-first search with current arcs: advance along the current arc, retreat and skip the arc
+//out of a dead end, augment by the bottleneck on reaching the sink and continue from the tail of the first
+//saturated arc. The path is an explicit stack of arcs, kept between augmentations
+class DfsBlockFlowFinder : public BlockFlowFinder {
+private:
+    vector <size_t> curArc;
+    vector <size_t> path;
+public:
+    void findBlockFlow();
+    void findBlockFlow(LevelGraph& levelGraph);
+};
+
+
 //**********************************************************************************************
-Graph::Graph(size_t vertices, vector <DirectEdge>& edges):sizeVert(vertices), sizeEdge(edges.size()), edgeList( *(new vector <DirectEdge>)), incomingList(*(new vector <vector <size_t> >(vertices))), outgoingList(*(new vector <vector <size_t> >(vertices)))
+Graph::Graph(size_t vertices, EdgeColumns& edges):_mapping(nullptr), sizeVert(vertices), sizeEdge(edges.size()),
+declaredSource(0), declaredSink(vertices ? vertices - 1 : 0)
 {
-    edgeList = edges;
-    DirectEdge curEdge;
-    for(size_t i = 0;i < edges.size(); ++i)
-    {
-        curEdge = edgeList[i];
-        outgoingList[curEdge.start].push_back(i);
-        incomingList[curEdge.finish].push_back(i);
-    }
+    _edgeStorage.swap(edges);
+    _bindEdgeStorage();
+    _buildAdjacency();
 }
 
-Graph::~Graph()
+Graph::Graph(size_t vertices, vector <DirectEdge>& edges):_mapping(nullptr), sizeVert(vertices), sizeEdge(edges.size()),
+declaredSource(0), declaredSink(vertices ? vertices - 1 : 0)
 {
-    delete &incomingList;
-    delete &outgoingList;
-    delete &edgeList;
+    _edgeStorage.resize(sizeEdge);
+    for(size_t i = 0;i < sizeEdge; ++i) {
+        _edgeStorage.start[i] = edges[i].start;
+        _edgeStorage.finish[i] = edges[i].finish;
+        _edgeStorage.capacity[i] = edges[i].capacity;
+    }
+    vector <DirectEdge>().swap(edges);
+    _bindEdgeStorage();
+    _buildAdjacency();
 }
 
+//sections of a binary graph file start at 8-byte boundaries
+inline size_t binaryGraphSection(size_t bytes) {
+    return (bytes + 7) & ~static_cast<size_t>(7);
+}
 
-Network::Network(Graph *graph, size_t source, size_t sink): graph(graph), sink(sink), source(source), maxFlow(0)
+Graph::Graph(MappedFile* mapping):_mapping(mapping)
 {
-    flow.resize(graph->sizeEdge, 0);
+    const BinaryGraphHeader* header = reinterpret_cast<const BinaryGraphHeader*>(mapping->data());
+    sizeVert = header->sizeVert;
+    sizeEdge = header->sizeEdge;
+    declaredSource = header->source;
+    declaredSink = header->sink;
+    
+    const char* section = mapping->data() + binaryGraphSection(sizeof(BinaryGraphHeader));
+    edgeStart = ArrayView <const IndexType>(reinterpret_cast<const IndexType*>(section), sizeEdge);
+    section += binaryGraphSection(sizeEdge * sizeof(IndexType));
+    edgeFinish = ArrayView <const IndexType>(reinterpret_cast<const IndexType*>(section), sizeEdge);
+    section += binaryGraphSection(sizeEdge * sizeof(IndexType));
+    edgeCapacity = ArrayView <const CapacityType>(reinterpret_cast<const CapacityType*>(section), sizeEdge);
+    section += binaryGraphSection(sizeEdge * sizeof(CapacityType));
+    
+    _bindAdjacency(reinterpret_cast<const IndexType*>(section));
 }
 
-Network::~Network()
+void Graph::_bindEdgeStorage()
 {
-    delete graph;
-    //delete flow;
+    edgeStart = ArrayView <const IndexType>(sizeEdge ? &_edgeStorage.start[0] : nullptr, sizeEdge);
+    edgeFinish = ArrayView <const IndexType>(sizeEdge ? &_edgeStorage.finish[0] : nullptr, sizeEdge);
+    edgeCapacity = ArrayView <const CapacityType>(sizeEdge ? &_edgeStorage.capacity[0] : nullptr, sizeEdge);
 }
 
-size_t Network::getMaxFlow(FlowFinder& flowFinder) {
-    flowFinder.initFlowFinder(this);
-    flowFinder.getMaxFlow();
-    return maxFlow = flowFinder.maxFlow;
+//both offset arrays and both edge id arrays back to back, as in _adjacencyStorage and in a binary graph file
+void Graph::_bindAdjacency(const IndexType* adjacency)
+{
+    outgoingList.offsets = ArrayView <const IndexType>(adjacency, sizeVert + 1);
+    outgoingList.edgeIds = ArrayView <const IndexType>(adjacency + sizeVert + 1, sizeEdge);
+    incomingList.offsets = ArrayView <const IndexType>(adjacency + sizeVert + 1 + sizeEdge, sizeVert + 1);
+    incomingList.edgeIds = ArrayView <const IndexType>(adjacency + 2 * (sizeVert + 1) + sizeEdge, sizeEdge);
 }
 
-DinicFlowFinder::DinicFlowFinder(BlockFlowFinder* blockFlowFinder): blockFlowFinder(blockFlowFinder), shortPathNetwork(nullptr)
+//counting sort of edge ids by start and by finish, so every list keeps edges in input order
+void Graph::_buildAdjacency()
 {
+    _adjacencyStorage.assign(2 * (sizeVert + 1 + sizeEdge), 0);
+    IndexType* adjacency = &_adjacencyStorage[0];
+    _bindAdjacency(adjacency);
+    
+    IndexType* outOffsets = adjacency;
+    IndexType* outEdgeIds = adjacency + sizeVert + 1;
+    IndexType* inOffsets = adjacency + sizeVert + 1 + sizeEdge;
+    IndexType* inEdgeIds = adjacency + 2 * (sizeVert + 1) + sizeEdge;
+    for(size_t i = 0;i < sizeEdge; ++i) {
+        ++outOffsets[edgeStart[i] + 1];
+        ++inOffsets[edgeFinish[i] + 1];
+    }
+    for(size_t vert = 0;vert < sizeVert; ++vert) {
+        outOffsets[vert + 1] += outOffsets[vert];
+        inOffsets[vert + 1] += inOffsets[vert];
+    }
+    for(size_t i = 0;i < sizeEdge; ++i) {
+        outEdgeIds[outOffsets[edgeStart[i]]++] = i;
+        inEdgeIds[inOffsets[edgeFinish[i]]++] = i;
+    }
+    for(size_t vert = sizeVert;vert > 0; --vert) {
+        outOffsets[vert] = outOffsets[vert - 1];
+        inOffsets[vert] = inOffsets[vert - 1];
+    }
+    outOffsets[0] = 0;
+    inOffsets[0] = 0;
 }
 
-DinicFlowFinder::~DinicFlowFinder() {
-    blockFlowFinder->~BlockFlowFinder();
+DirectEdge Graph::edge(size_t edgeNumber) const
+{
+    DirectEdge curEdge;
+    curEdge.start = edgeStart[edgeNumber];
+    curEdge.finish = edgeFinish[edgeNumber];
+    curEdge.capacity = edgeCapacity[edgeNumber];
+    return curEdge;
 }
 
-void DinicFlowFinder::initFlowFinder(Network* network) {
-    this->network = network;
-    maxFlow = 0;
+size_t Graph::memoryBytes() const
+{
+    return sizeEdge * (2 * sizeof(IndexType) + sizeof(CapacityType)) + 2 * (sizeVert + 1 + sizeEdge) * sizeof(IndexType);
 }
 
-void DinicFlowFinder::calcMaxFlow() {
-    vector <DirectEdge>& edgeList = network->graph->edgeList;
-    vector <size_t>& flow = network->flow;
-    size_t source = network->source;
-    
-    for(size_t i = 0;i < edgeList.size(); ++i) {
-        if(edgeList[i].start == source) {
-            maxFlow += flow[i];
-        }
-        if(edgeList[i].finish == source) {
-            maxFlow -= flow[i];
-        }
+Graph::~Graph()
+{
+    delete _mapping;
+}
+
+size_t peakMemoryKilobytes() {
+#ifndef _WIN32
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_maxrss;
     }
+#endif
+    return 0;
 }
 
-void DinicFlowFinder::updateFlow() {
-    DirectEdge originalEdge;
-    DirectEdge imageEdge;
-    vector <DirectEdge>& originEdgeList = network->graph->edgeList;
-    vector <DirectEdge>& shortPathEdgeList = shortPathNetwork->graph->edgeList;
+bool isBinaryGraph(const char* data, size_t size) {
+    return size >= sizeof(BinaryGraphHeader) && equal(BINARY_GRAPH_MAGIC, BINARY_GRAPH_MAGIC + 8, data);
+}
+
+//writes count elements of size bytes and pads up to the next section boundary
+bool writeBinaryGraphSection(FILE* file, const void* data, size_t size, size_t count) {
+    static const char padding[8] = {0};
+    size_t paddingBytes = binaryGraphSection(size * count) - size * count;
+    return fwrite(data, size, count, file) == count && fwrite(padding, 1, paddingBytes, file) == paddingBytes;
+}
+
+bool writeBinaryGraph(const char* path, Graph& graph) {
+    FILE* file = fopen(path, "wb");
+    if(!file) {
+        return false;
+    }
     
-    for(size_t i = 0;i < shortPathNetwork->edgeID.size(); ++i) {
-        originalEdge = originEdgeList[shortPathNetwork->edgeID[i]];
-        imageEdge = shortPathEdgeList[i];
-        if(originalEdge.start == imageEdge.start) {
-            network->flow[shortPathNetwork->edgeID[i]] += shortPathNetwork->flow[i];
-        } else {
-            network->flow[shortPathNetwork->edgeID[i]] -= shortPathNetwork->flow[i];
-        }
+    BinaryGraphHeader header;
+    copy(BINARY_GRAPH_MAGIC, BINARY_GRAPH_MAGIC + 8, header.magic);
+    header.version = BINARY_GRAPH_VERSION;
+    header.byteOrder = BINARY_GRAPH_BYTE_ORDER;
+    header.indexBytes = sizeof(IndexType);
+    header.capacityBytes = sizeof(CapacityType);
+    header.sizeVert = graph.sizeVert;
+    header.sizeEdge = graph.sizeEdge;
+    header.source = graph.declaredSource;
+    header.sink = graph.declaredSink;
+    
+    bool written = writeBinaryGraphSection(file, &header, sizeof(header), 1);
+    written = written && writeBinaryGraphSection(file, graph.edgeStart.begin(), sizeof(IndexType), graph.sizeEdge);
+    written = written && writeBinaryGraphSection(file, graph.edgeFinish.begin(), sizeof(IndexType), graph.sizeEdge);
+    written = written && writeBinaryGraphSection(file, graph.edgeCapacity.begin(), sizeof(CapacityType), graph.sizeEdge);
+    AdjacencyList* lists[2] = {&graph.outgoingList, &graph.incomingList};
+    for(size_t i = 0;i < 2; ++i) {
+        written = written && fwrite(lists[i]->offsets.begin(), sizeof(IndexType), graph.sizeVert + 1, file) == graph.sizeVert + 1;
+        written = written && fwrite(lists[i]->edgeIds.begin(), sizeof(IndexType), graph.sizeEdge, file) == graph.sizeEdge;
     }
+    return (fclose(file) == 0) && written;
 }
 
-void DinicFlowFinder::getMaxFlow() {
-    while(getShortPathNetwork()) {
+//the mapped arrays are used without bound checks afterwards, so everything the text parser
+//guarantees is checked here once: endpoints in range and lists that partition the edges by vertex
+const char* checkBinaryGraph(const Graph& graph) {
+    if(graph.declaredSource >= max(graph.sizeVert, static_cast<size_t>(1)) || graph.declaredSink >= max(graph.sizeVert, static_cast<size_t>(1))) {
+        return "source or sink out of range";
+    }
+    for(size_t i = 0;i < graph.sizeEdge; ++i) {
+        if(graph.edgeStart[i] >= graph.sizeVert || graph.edgeFinish[i] >= graph.sizeVert) {
+            return "edge endpoint out of range";
+        }
+    }
+    const AdjacencyList* lists[2] = {&graph.outgoingList, &graph.incomingList};
+    const ArrayView <const IndexType>* ends[2] = {&graph.edgeStart, &graph.edgeFinish};
+    for(size_t i = 0;i < 2; ++i) {
+        const ArrayView <const IndexType>& offsets = lists[i]->offsets;
+        if(offsets[0] != 0 || offsets[graph.sizeVert] != graph.sizeEdge) {
+            return "adjacency offsets don't span the edges";
+        }
+        for(size_t vert = 0;vert < graph.sizeVert; ++vert) {
+            if(offsets[vert] > offsets[vert + 1]) {
+                return "adjacency offsets decrease";
+            }
+        }
+        for(size_t vert = 0;vert < graph.sizeVert; ++vert) {
+            for(size_t pos = offsets[vert];pos < offsets[vert + 1]; ++pos) {
+                IndexType edgeId = lists[i]->edgeIds[pos];
+                if(edgeId >= graph.sizeEdge || (*ends[i])[edgeId] != vert) {
+                    return "adjacency list names an edge of another vertex";
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
+BulkWriter::BulkWriter(FILE* file, size_t bufferBytes): _file(file), _buffer(bufferBytes), _used(0), _failed(false) {
+}
+
+BulkWriter::~BulkWriter() {
+    flush();
+}
+
+char* BulkWriter::formatNumber(char* out, unsigned long long value) {
+    char digits[20];
+    char* digit = digits + 20;
+    do {
+        *--digit = '0' + value % 10;
+        value /= 10;
+    } while(value);
+    return copy(digit, digits + 20, out);
+}
+
+void BulkWriter::write(const char* data, size_t size) {
+    if(_used + size > _buffer.size()) {
+        flush();
+        if(size > _buffer.size()) {
+            _failed = _failed || fwrite(data, 1, size, _file) != size;
+            return;
+        }
+    }
+    copy(data, data + size, &_buffer[_used]);
+    _used += size;
+}
+
+void BulkWriter::writeNumber(unsigned long long value) {
+    if(_used + 20 > _buffer.size()) {
+        flush();
+    }
+    _used = formatNumber(&_buffer[_used], value) - &_buffer[0];
+}
+
+void BulkWriter::writeChar(char symbol) {
+    write(&symbol, 1);
+}
+
+bool BulkWriter::flush() {
+    if(_used) {
+        _failed = _failed || fwrite(&_buffer[0], 1, _used, _file) != _used;
+        _used = 0;
+    }
+    return !_failed;
+}
+
+bool writeDimacsFlow(const char* path, Network& network, ThreadPool* pool) {
+    FILE* file = fopen(path, "w");
+    if(!file) {
+        return false;
+    }
+    
+    Graph* graph = network.graph;
+    bool written;
+    {
+        BulkWriter writer(file);
+        char header[128];
+        int headerBytes = snprintf(header, sizeof(header), "c max flow from %zu to %zu\ns %lld\n",
+                                   network.source + 1, network.sink + 1, network.maxFlow);
+        writer.write(header, headerBytes);
+        written = writer.writeLines(graph->sizeEdge, 64, pool, [&](char* out, size_t i) {
+            *out++ = 'f';
+            *out++ = ' ';
+            out = BulkWriter::formatNumber(out, static_cast<unsigned long long>(graph->edgeStart[i]) + 1);
+            *out++ = ' ';
+            out = BulkWriter::formatNumber(out, static_cast<unsigned long long>(graph->edgeFinish[i]) + 1);
+            *out++ = ' ';
+            out = BulkWriter::formatNumber(out, network.flow[i]);
+            *out++ = '\n';
+            return out;
+        });
+    }
+    return (fclose(file) == 0) && written;
+}
+
+bool writeFlowText(const char* path, Network& network, ThreadPool* pool) {
+    FILE* file = fopen(path, "w");
+    if(!file) {
+        return false;
+    }
+    
+    bool written;
+    {
+        BulkWriter writer(file);
+        written = writer.writeLines(network.flow.size(), 24, pool, [&](char* out, size_t i) {
+            out = BulkWriter::formatNumber(out, network.flow[i]);
+            *out++ = '\n';
+            return out;
+        });
+    }
+    return (fclose(file) == 0) && written;
+}
+
+bool writeFlowBinary(const char* path, Network& network) {
+    FILE* file = fopen(path, "wb");
+    if(!file) {
+        return false;
+    }
+    size_t count = network.flow.size();
+    bool written = count == 0 || fwrite(&network.flow[0], sizeof(CapacityType), count, file) == count;
+    return (fclose(file) == 0) && written;
+}
+
+bool writeMinCut(const char* path, Network& network, MinCut& cut) {
+    FILE* file = fopen(path, "w");
+    if(!file) {
+        return false;
+    }
+    
+    Graph* graph = network.graph;
+    bool written;
+    {
+        BulkWriter writer(file);
+        char header[160];
+        int headerBytes = snprintf(header, sizeof(header), "c min cut of capacity %lld, %zu source side vertices, %zu cut edges\n",
+                                   cut.capacity, cut.sourceVertices.size(), cut.cutEdges.size());
+        writer.write(header, headerBytes);
+        written = writer.writeLines(cut.sourceVertices.size(), 24, nullptr, [&](char* out, size_t i) {
+            *out++ = 'v';
+            *out++ = ' ';
+            out = BulkWriter::formatNumber(out, static_cast<unsigned long long>(cut.sourceVertices[i]) + 1);
+            *out++ = '\n';
+            return out;
+        });
+        written = written && writer.writeLines(cut.cutEdges.size(), 88, nullptr, [&](char* out, size_t i) {
+            size_t edge = cut.cutEdges[i];
+            *out++ = 'e';
+            *out++ = ' ';
+            out = BulkWriter::formatNumber(out, static_cast<unsigned long long>(edge) + 1);
+            *out++ = ' ';
+            out = BulkWriter::formatNumber(out, static_cast<unsigned long long>(graph->edgeStart[edge]) + 1);
+            *out++ = ' ';
+            out = BulkWriter::formatNumber(out, static_cast<unsigned long long>(graph->edgeFinish[edge]) + 1);
+            *out++ = ' ';
+            out = BulkWriter::formatNumber(out, graph->edgeCapacity[edge]);
+            *out++ = '\n';
+            return out;
+        });
+    }
+    return (fclose(file) == 0) && written;
+}
+
+GraphFormat detectGraphFormat(const char* data, size_t size) {
+    if(isBinaryGraph(data, size)) {
+        return FORMAT_BINARY;
+    }
+    const char* pos = data;
+    while(pos != data + size && static_cast<unsigned char>(*pos) <= ' ') {
+        ++pos;
+    }
+    if(pos != data + size && (*pos == 'c' || *pos == 'p')) {
+        return FORMAT_DIMACS;
+    }
+    return FORMAT_NATIVE;
+}
+
+Graph* loadGraphFile(const char* path, LoadStats* stats, ThreadPool* pool, GraphFormat format) {
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    
+    MappedFile* file = new MappedFile();
+    if(!file->open(path)) {
+        cerr << "can't open " << path << endl;
+        delete file;
+        return nullptr;
+    }
+    
+    Graph* graph = nullptr;
+    size_t fileSize = file->size();
+    GraphFormat detectedFormat = detectGraphFormat(file->data(), file->size());
+    if(format == FORMAT_AUTO) {
+        format = detectedFormat;
+    } else if((format == FORMAT_BINARY) != (detectedFormat == FORMAT_BINARY)) {
+        cerr << path << ": file is " << (detectedFormat == FORMAT_BINARY ? "" : "not ") << "a binary graph" << endl;
+        delete file;
+        return nullptr;
+    }
+    if(format == FORMAT_BINARY) {
+        const BinaryGraphHeader* header = reinterpret_cast<const BinaryGraphHeader*>(file->data());
+        size_t expectedSize = binaryGraphSection(sizeof(BinaryGraphHeader))
+                            + 2 * binaryGraphSection(header->sizeEdge * sizeof(IndexType))
+                            + binaryGraphSection(header->sizeEdge * sizeof(CapacityType))
+                            + 2 * (header->sizeVert + 1 + header->sizeEdge) * sizeof(IndexType);
+        if(header->version != BINARY_GRAPH_VERSION || header->byteOrder != BINARY_GRAPH_BYTE_ORDER
+           || header->indexBytes != sizeof(IndexType) || header->capacityBytes != sizeof(CapacityType)
+           || header->sizeVert >= UNREACHED || header->sizeEdge >= UNREACHED
+           || header->sizeVert > fileSize || header->sizeEdge > fileSize || fileSize != expectedSize) {
+            cerr << path << ": binary graph was written by an incompatible build" << endl;
+            delete file;
+            return nullptr;
+        }
+        graph = new Graph(file);
+        const char* inconsistency = checkBinaryGraph(*graph);
+        if(inconsistency) {
+            cerr << path << ": " << inconsistency << endl;
+            delete graph; //also unmaps the file
+            return nullptr;
+        }
+    } else {
+        size_t sizeVert;
+        EdgeColumns edges;
+        EdgeListParser parser(file->data(), file->data() + file->size(), format);
+        bool parsed = (pool && pool->size() > 1) ? parser.parseParallel(*pool, sizeVert, edges) : parser.parse(sizeVert, edges);
+        if(!parsed) {
+            cerr << path << ": " << parser.error << " at byte " << parser.errorOffset() << endl;
+            delete file;
+            return nullptr;
+        }
+        delete file; //unmap the text before the adjacency is allocated
+        graph = new Graph(sizeVert, edges);
+        graph->declaredSource = parser.source;
+        graph->declaredSink = parser.sink;
+    }
+    
+    if(stats) {
+        stats->bytes = fileSize;
+        stats->threads = pool ? pool->size() : 1;
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+    return graph;
+}
+
+Network::Network(Graph *graph, size_t source, size_t sink): graph(graph), sink(sink), source(source), maxFlow(0)
+{
+    flow.resize(graph->sizeEdge, 0);
+}
+
+Network::~Network()
+{
+    delete graph;
+    //delete flow;
+}
+
+void Network::reset(size_t source, size_t sink) {
+    this->source = source;
+    this->sink = sink;
+    maxFlow = 0;
+    flow.assign(graph->sizeEdge, 0);
+}
+
+size_t Network::getMaxFlow(FlowFinder& flowFinder) {
+    flowFinder.initFlowFinder(this);
+    flowFinder.getMaxFlow();
+    return maxFlow = flowFinder.maxFlow;
+}
+
+void MinCut::build(Network* network, const vector <bool>& reachable) {
+    Graph* graph = network->graph;
+    sourceSide = reachable;
+    sourceVertices.clear();
+    cutEdges.clear();
+    capacity = 0;
+    for(size_t vert = 0;vert < graph->sizeVert; ++vert) {
+        if(sourceSide[vert]) {
+            sourceVertices.push_back(vert);
+        }
+    }
+    for(size_t i = 0;i < graph->sizeEdge; ++i) {
+        if(sourceSide[graph->edgeStart[i]] && !sourceSide[graph->edgeFinish[i]]) {
+            cutEdges.push_back(i);
+            capacity += graph->edgeCapacity[i];
+        }
+    }
+}
+
+void FlowFinder::getMinCut(MinCut& cut) {
+    Bfs bfs;
+    bfs.init(network);
+    bfs.run();
+    cut.build(network, *bfs.used);
+}
+
+DinicFlowFinder::DinicFlowFinder(BlockFlowFinder* blockFlowFinder, bool useLevelGraphView): blockFlowFinder(blockFlowFinder),
+shortPathNetwork(nullptr), useLevelGraphView(useLevelGraphView), pruneLevelGraph(true), countLevelArcs(false),
+minResidual(1)
+{
+}
+
+DinicFlowFinder::~DinicFlowFinder() {
+    //blockFlowFinder belongs to the caller
+}
+
+void DinicFlowFinder::initFlowFinder(Network* network) {
+    this->network = network;
+    maxFlow = 0;
+    phaseCount = 0;
+    bfsEdgesExamined = 0;
+    levelArcCounts.clear();
+}
+
+void DinicFlowFinder::calcMaxFlow() {
+    Graph* graph = network->graph;
+    vector <CapacityType>& flow = network->flow;
+    size_t source = network->source;
+    
+    for(size_t i = 0;i < graph->sizeEdge; ++i) {
+        if(graph->edgeStart[i] == source) {
+            maxFlow += flow[i];
+        }
+        if(graph->edgeFinish[i] == source) {
+            maxFlow -= flow[i];
+        }
+    }
+}
+
+void DinicFlowFinder::updateFlow() {
+    ArrayView <const IndexType>& originStart = network->graph->edgeStart;
+    ArrayView <const IndexType>& shortPathStart = shortPathNetwork->graph->edgeStart;
+    
+    for(size_t i = 0;i < shortPathNetwork->edgeID.size(); ++i) {
+        if(originStart[shortPathNetwork->edgeID[i]] == shortPathStart[i]) {
+            network->flow[shortPathNetwork->edgeID[i]] += shortPathNetwork->flow[i];
+        } else {
+            network->flow[shortPathNetwork->edgeID[i]] -= shortPathNetwork->flow[i];
+        }
+    }
+}
+
+void DinicFlowFinder::getMinCut(MinCut& cut) {
+    cut.build(network, *bfs.used);
+}
+
+void DinicFlowFinder::getMaxFlow() {
+    runPhases();
+    calcMaxFlow();
+    
+    return;
+}
+
+//blocking flows until the sink is unreachable over residual edges of at least minResidual
+void DinicFlowFinder::runPhases() {
+    if(useLevelGraphView) {
+        while(getLevelGraph()) {
+            blockFlowFinder->findBlockFlow(levelGraph);
+        }
+        return;
+    }
+    
+    while(getShortPathNetwork()) {
         blockFlowFinder->shortPathNetwork = shortPathNetwork;
         blockFlowFinder->findBlockFlow();
         
         updateFlow();
         delete shortPathNetwork;
     }
+}
+
+ScalingDinicFlowFinder::ScalingDinicFlowFinder(BlockFlowFinder* blockFlowFinder, bool useLevelGraphView):
+DinicFlowFinder(blockFlowFinder, useLevelGraphView), roundCount(0)
+{
+}
+
+void ScalingDinicFlowFinder::getMaxFlow() {
+    Graph* graph = network->graph;
+    CapacityType maxCapacity = 0;
+    for(size_t i = 0;i < graph->sizeEdge; ++i) {
+        maxCapacity = max(maxCapacity, graph->edgeCapacity[i]);
+    }
+    
+    roundCount = 0;
+    for(CapacityType delta = largestPowerOfTwo(maxCapacity);delta > 0; ) {
+        minResidual = delta;
+        runPhases();
+        ++roundCount;
+        //rounds with a delta above every residual edge leaving the last bfs tree find nothing, skip them
+        delta = min(delta / 2, largestPowerOfTwo(maxLeavingResidual()));
+    }
+    minResidual = 1;
+    calcMaxFlow();
+}
+
+//largest residual capacity of an edge from a vertex the last bfs reached to one it didn't
+CapacityType ScalingDinicFlowFinder::maxLeavingResidual() {
+    Graph* graph = network->graph;
+    const vector <bool>& reached = *bfs.used;
+    CapacityType maxResidual = 0;
+    for(size_t i = 0;i < graph->sizeEdge; ++i) {
+        IndexType start = graph->edgeStart[i];
+        IndexType finish = graph->edgeFinish[i];
+        if(reached[start] && !reached[finish] && start != network->sink) {
+            maxResidual = max(maxResidual, graph->edgeCapacity[i] - network->flow[i]);
+        } else if(reached[finish] && !reached[start] && finish != network->sink) {
+            maxResidual = max(maxResidual, network->flow[i]);
+        }
+    }
+    return maxResidual;
+}
+
+CapacityType largestPowerOfTwo(CapacityType limit) {
+    if(limit == 0) {
+        return 0;
+    }
+    CapacityType power = 1;
+    while(power <= limit / 2) {
+        power *= 2;
+    }
+    return power;
+}
+
+PushRelabelFlowFinder::PushRelabelFlowFinder(): minCutOnly(false) {
+}
+
+void PushRelabelFlowFinder::initFlowFinder(Network* network) {
+    this->network = network;
+    maxFlow = 0;
+    pushCount = 0;
+    relabelCount = 0;
+    globalRelabelCount = 0;
+    gapCount = 0;
+}
+
+void PushRelabelFlowFinder::_addActive(IndexType vert) {
+    IndexType label = _label[vert];
+    _nextActive[vert] = _activeHead[label];
+    _activeHead[label] = vert;
+    _maxActive = max(_maxActive, label);
+}
+
+void PushRelabelFlowFinder::_addToBucket(IndexType vert) {
+    IndexType label = _label[vert];
+    _prevInBucket[vert] = UNREACHED;
+    _nextInBucket[vert] = _bucketHead[label];
+    if(_bucketHead[label] != UNREACHED) {
+        _prevInBucket[_bucketHead[label]] = vert;
+    }
+    _bucketHead[label] = vert;
+    _maxLabel = max(_maxLabel, label);
+}
+
+void PushRelabelFlowFinder::_removeFromBucket(IndexType vert) {
+    if(_prevInBucket[vert] != UNREACHED) {
+        _nextInBucket[_prevInBucket[vert]] = _nextInBucket[vert];
+    } else {
+        _bucketHead[_label[vert]] = _nextInBucket[vert];
+    }
+    if(_nextInBucket[vert] != UNREACHED) {
+        _prevInBucket[_nextInBucket[vert]] = _prevInBucket[vert];
+    }
+}
+
+//exact labels: residual distance to _target, V for vertices that can't reach it; rebuilds the buckets
+void PushRelabelFlowFinder::_globalRelabel() {
+    Graph* graph = network->graph;
+    IndexType sizeVert = graph->sizeVert;
+    const CapacityType* flow = _residual.flow;
+    ++globalRelabelCount;
+    _workSinceGlobalRelabel = 0;
+    
+    _label.assign(sizeVert, sizeVert);
+    _activeHead.assign(sizeVert + 1, UNREACHED);
+    _bucketHead.assign(sizeVert + 1, UNREACHED);
+    _maxActive = 0;
+    _maxLabel = 0;
+    
+    //the reverse bfs queue is _nextActive used as an array, it is rebuilt below anyway
+    vector <IndexType>& bfsQueue = _nextActive;
+    size_t queueBegin = 0;
+    size_t queueEnd = 0;
+    _label[_target] = 0;
+    bfsQueue[queueEnd++] = _target;
+    while(queueBegin != queueEnd) {
+        IndexType vert = bfsQueue[queueBegin++];
+        IndexType prevLabel = _label[vert] + 1;
+        const IndexType* edgeIds = graph->incomingList.edgeIds.begin();
+        const IndexType* edgeIdsEnd = edgeIds + graph->incomingList.offsets[vert + 1];
+        for(edgeIds += graph->incomingList.offsets[vert];edgeIds != edgeIdsEnd;++edgeIds) {
+            IndexType prevVert = graph->edgeStart[*edgeIds];
+            if(_label[prevVert] == sizeVert && prevVert != _otherTerminal && flow[*edgeIds] < graph->edgeCapacity[*edgeIds]) {
+                _label[prevVert] = prevLabel;
+                bfsQueue[queueEnd++] = prevVert;
+            }
+        }
+        edgeIds = graph->outgoingList.edgeIds.begin();
+        edgeIdsEnd = edgeIds + graph->outgoingList.offsets[vert + 1];
+        for(edgeIds += graph->outgoingList.offsets[vert];edgeIds != edgeIdsEnd;++edgeIds) {
+            IndexType prevVert = graph->edgeFinish[*edgeIds];
+            if(_label[prevVert] == sizeVert && prevVert != _otherTerminal && flow[*edgeIds] > 0) {
+                _label[prevVert] = prevLabel;
+                bfsQueue[queueEnd++] = prevVert;
+            }
+        }
+    }
+    
+    for(IndexType vert = 0;vert < sizeVert; ++vert) {
+        _curArc[vert] = _residual.firstArc(vert);
+        if(_label[vert] < sizeVert && vert != _target) {
+            _addToBucket(vert);
+            if(_excess[vert] > 0) {
+                _addActive(vert);
+            }
+        }
+    }
+}
+
+//no vertex is left with emptyLabel: the ones above can't reach the target any more
+void PushRelabelFlowFinder::_gap(IndexType emptyLabel) {
+    IndexType sizeVert = network->graph->sizeVert;
+    ++gapCount;
+    for(IndexType label = emptyLabel + 1;label <= _maxLabel; ++label) {
+        for(IndexType vert = _bucketHead[label];vert != UNREACHED; vert = _nextInBucket[vert]) {
+            _label[vert] = sizeVert;
+        }
+        _bucketHead[label] = UNREACHED;
+        _activeHead[label] = UNREACHED;
+    }
+    _maxLabel = emptyLabel - 1;
+}
+
+//one above the lowest neighbour over a residual arc, or V (gap or no residual arc left)
+void PushRelabelFlowFinder::_relabel(IndexType vert) {
+    IndexType sizeVert = network->graph->sizeVert;
+    IndexType oldLabel = _label[vert];
+    ++relabelCount;
+    _removeFromBucket(vert);
+    if(_bucketHead[oldLabel] == UNREACHED) {
+        _label[vert] = sizeVert;
+        _gap(oldLabel);
+        return;
+    }
+    
+    IndexType newLabel = sizeVert;
+    size_t minArc = 0;
+    size_t end = _residual.arcEnd(vert);
+    for(size_t arc = _residual.firstArc(vert);arc != end; _residual.nextArc(vert, arc)) {
+        if(_residual.arcResidual(arc) > 0 && _label[_residual.arcHead(arc)] + 1 < newLabel) {
+            newLabel = _label[_residual.arcHead(arc)] + 1;
+            minArc = arc;
+        }
+    }
+    _workSinceGlobalRelabel += 12 + network->graph->outgoingList.degree(vert) + network->graph->incomingList.degree(vert);
+    _label[vert] = newLabel;
+    if(newLabel < sizeVert) {
+        _curArc[vert] = minArc;
+        _addToBucket(vert);
+    }
+}
+
+//pushes the excess of vert over admissible arcs (to a label one lower), relabels when they run out
+void PushRelabelFlowFinder::_discharge(IndexType vert) {
+    IndexType sizeVert = network->graph->sizeVert;
+    while(true) {
+        IndexType nextLabel = _label[vert] - 1;
+        size_t arc = _curArc[vert];
+        size_t end = _residual.arcEnd(vert);
+        for(;arc != end; _residual.nextArc(vert, arc)) {
+            IndexType nextVert = _residual.arcHead(arc);
+            if(_label[nextVert] != nextLabel) {
+                continue;
+            }
+            CapacityType residual = _residual.arcResidual(arc);
+            if(residual == 0) {
+                continue;
+            }
+            CapacityType pushed = _excess[vert] < residual ? static_cast<CapacityType>(_excess[vert]) : residual;
+            _residual.pushFlow(arc, pushed);
+            ++pushCount;
+            if(_excess[nextVert] == 0 && nextVert != _target && nextVert != _otherTerminal) {
+                _addActive(nextVert);
+            }
+            _excess[nextVert] += pushed;
+            _excess[vert] -= pushed;
+            if(_excess[vert] == 0) {
+                break;
+            }
+        }
+        if(arc != end) {
+            _curArc[vert] = arc;
+            return;
+        }
+        _relabel(vert);
+        if(_label[vert] >= sizeVert) {
+            return;
+        }
+    }
+}
+
+//discharges the highest active vertex until none is left below V
+void PushRelabelFlowFinder::_runPhase(size_t target, size_t otherTerminal) {
+    Graph* graph = network->graph;
+    _target = target;
+    _otherTerminal = otherTerminal;
+    _globalRelabel();
+    size_t globalRelabelWork = 6 * graph->sizeVert + graph->sizeEdge;
+    while(true) {
+        while(_maxActive > 0 && _activeHead[_maxActive] == UNREACHED) {
+            --_maxActive;
+        }
+        IndexType vert = _activeHead[_maxActive];
+        if(vert == UNREACHED) {
+            break;
+        }
+        _activeHead[_maxActive] = _nextActive[vert];
+        _discharge(vert);
+        if(_workSinceGlobalRelabel > globalRelabelWork) {
+            _globalRelabel();
+        }
+    }
+}
+
+void PushRelabelFlowFinder::getMaxFlow() {
+    Graph* graph = network->graph;
+    size_t sizeVert = graph->sizeVert;
+    size_t source = network->source;
+    size_t sink = network->sink;
+    _residual.init(network);
+    _curArc.resize(sizeVert);
+    _nextActive.resize(sizeVert);
+    _nextInBucket.resize(sizeVert);
+    _prevInBucket.resize(sizeVert);
+    
+    //excess of the flow we start with, zero unless the network already carries flow
+    _excess.assign(sizeVert, 0);
+    for(size_t i = 0;i < graph->sizeEdge; ++i) {
+        _excess[graph->edgeFinish[i]] += _residual.flow[i];
+        _excess[graph->edgeStart[i]] -= _residual.flow[i];
+    }
+    //preflow: every residual arc out of the source is saturated
+    size_t end = _residual.arcEnd(source);
+    for(size_t arc = _residual.firstArc(source);arc != end; _residual.nextArc(source, arc)) {
+        CapacityType residual = _residual.arcResidual(arc);
+        if(residual > 0 && _residual.arcHead(arc) != source) {
+            _residual.pushFlow(arc, residual);
+            _excess[_residual.arcHead(arc)] += residual;
+            _excess[source] -= residual;
+        }
+    }
+    
+    _runFirstPhase();
+    maxFlow = _excess[sink];
+    //labels of the last global relabel are only lower bounds by now, the min cut needs exact reachability
+    _globalRelabel();
+    _sourceSide.resize(sizeVert);
+    for(size_t vert = 0;vert < sizeVert; ++vert) {
+        _sourceSide[vert] = _label[vert] == sizeVert;
+    }
+    if(!minCutOnly) {
+        _runPhase(source, sink);
+    }
+}
+
+void PushRelabelFlowFinder::_runFirstPhase() {
+    _runPhase(network->sink, network->source);
+}
+
+void PushRelabelFlowFinder::getMinCut(MinCut& cut) {
+    cut.build(network, _sourceSide);
+}
+
+ParallelPushRelabelFlowFinder::ParallelPushRelabelFlowFinder(ThreadPool* pool): _pool(pool), roundCount(0) {
+}
+
+//of two working neighbours, the one whose pushes between them are consistent with both labels, ties to the lower number
+bool ParallelPushRelabelFlowFinder::_wins(IndexType vert, IndexType nextVert) const {
+    IndexType label = _label[vert];
+    IndexType nextLabel = _label[nextVert];
+    return label == nextLabel + 1 || label + 1 < nextLabel || (label == nextLabel && vert < nextVert);
+}
+
+//one pass of pushes over the arcs of vert against the labels of the round start, then at most one relabel, so
+//vert and its neighbours judge _wins on the same labels. The relabel is skipped when a working neighbour that
+//wins may change an arc of vert meanwhile: one vert can push into, or one that can push into vert. Such an arc
+//has the winner as its only writer and both ends use the relaxed atomic sharedArcResidual/sharedPushFlow, so
+//the loser judges both residual capacities by one value the winner stored. Otherwise vert alone writes its arcs
+//this round and the new label is exact; the working vertex with the highest label, lowest number among equal
+//ones, always goes through, so every round moves
+size_t ParallelPushRelabelFlowFinder::_parallelDischarge(IndexType vert, vector <IndexType>& discovered, size_t& pushes) {
+    IndexType sizeVert = network->graph->sizeVert;
+    long long excess = _excess[vert];
+    IndexType label = _label[vert];
+    size_t work = 0;
+    size_t end = _residual.arcEnd(vert);
+    IndexType newLabel = sizeVert;
+    bool skipped = false;
+    for(size_t arc = _residual.firstArc(vert);arc != end && excess > 0; _residual.nextArc(vert, arc)) {
+        IndexType nextVert = _residual.arcHead(arc);
+        if(nextVert == vert) {
+            continue;
+        }
+        CapacityType residual = _residual.sharedArcResidual(arc);
+        IndexType nextLabel = _label[nextVert];
+        if(_workingRound[nextVert] == _round && !_wins(vert, nextVert)) {
+            CapacityType reverseResidual = network->graph->edgeCapacity[_residual.arcEdge(arc)] - residual;
+            if(residual > 0 || (nextLabel == label + 1 && reverseResidual > 0)) {
+                skipped = true;
+            }
+            continue;
+        }
+        if(residual == 0) {
+            continue;
+        }
+        if(label == nextLabel + 1) {
+            CapacityType pushed = excess < residual ? static_cast<CapacityType>(excess) : residual;
+            _residual.sharedPushFlow(arc, pushed);
+            excess -= pushed;
+            residual -= pushed;
+            ++pushes;
+            __atomic_fetch_add(&_addedExcess[nextVert], static_cast<long long>(pushed), __ATOMIC_RELAXED);
+            if(nextVert != _target && _workingRound[nextVert] != _round &&
+               __atomic_exchange_n(&_discoveredRound[nextVert], _round, __ATOMIC_RELAXED) != _round) {
+                discovered.push_back(nextVert);
+            }
+        }
+        if(residual > 0 && nextLabel + 1 < newLabel) {
+            newLabel = nextLabel + 1;
+        }
+    }
+    if(excess > 0 && !skipped) {
+        work += 12 + network->graph->outgoingList.degree(vert) + network->graph->incomingList.degree(vert);
+        label = newLabel;
+    }
+    _excess[vert] = excess;
+    _newLabel[vert] = label;
+    return work;
+}
+
+void ParallelPushRelabelFlowFinder::_gatherThreadLists(vector <IndexType>& list) {
+    for(size_t i = 0;i < _threadLists.size(); ++i) {
+        list.insert(list.end(), _threadLists[i].begin(), _threadLists[i].end());
+        _threadLists[i].clear();
+    }
+}
+
+//exact labels by a level-synchronous reverse bfs from _target, each vertex claimed by one thread with a
+//compare-and-swap on its label; then the working set is every vertex below V with excess
+void ParallelPushRelabelFlowFinder::_parallelGlobalRelabel() {
+    Graph* graph = network->graph;
+    IndexType sizeVert = graph->sizeVert;
+    const CapacityType* flow = _residual.flow;
+    IndexType* labels = &_label[0];
+    ++globalRelabelCount;
+    _workSinceGlobalRelabel = 0;
+    
+    const size_t vertBlockSize = 4096;
+    size_t vertBlocks = (sizeVert + vertBlockSize - 1) / vertBlockSize;
+    _pool->parallelFor(vertBlocks, [&](size_t block, size_t) {
+        std::fill(labels + block * vertBlockSize, labels + min(static_cast<size_t>(sizeVert), (block + 1) * vertBlockSize), sizeVert);
+    });
+    vector <IndexType> frontier(1, _target);
+    labels[_target] = 0;
+    for(IndexType level = 0;!frontier.empty(); ++level) {
+        IndexType prevLabel = level + 1;
+        size_t blockSize = max(static_cast<size_t>(256), frontier.size() / (_pool->size() * 8) + 1);
+        _pool->parallelFor((frontier.size() + blockSize - 1) / blockSize, [&](size_t block, size_t threadIndex) {
+            vector <IndexType>& found = _threadLists[threadIndex];
+            size_t end = min(frontier.size(), (block + 1) * blockSize);
+            for(size_t i = block * blockSize;i < end; ++i) {
+                IndexType vert = frontier[i];
+                const IndexType* edgeIds = graph->incomingList.edgeIds.begin();
+                const IndexType* edgeIdsEnd = edgeIds + graph->incomingList.offsets[vert + 1];
+                for(edgeIds += graph->incomingList.offsets[vert];edgeIds != edgeIdsEnd;++edgeIds) {
+                    IndexType prevVert = graph->edgeStart[*edgeIds];
+                    IndexType unlabeled = sizeVert;
+                    if(__atomic_load_n(&labels[prevVert], __ATOMIC_RELAXED) == sizeVert && prevVert != _otherTerminal &&
+                       flow[*edgeIds] < graph->edgeCapacity[*edgeIds] &&
+                       __atomic_compare_exchange_n(&labels[prevVert], &unlabeled, prevLabel, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                        found.push_back(prevVert);
+                    }
+                }
+                edgeIds = graph->outgoingList.edgeIds.begin();
+                edgeIdsEnd = edgeIds + graph->outgoingList.offsets[vert + 1];
+                for(edgeIds += graph->outgoingList.offsets[vert];edgeIds != edgeIdsEnd;++edgeIds) {
+                    IndexType prevVert = graph->edgeFinish[*edgeIds];
+                    IndexType unlabeled = sizeVert;
+                    if(__atomic_load_n(&labels[prevVert], __ATOMIC_RELAXED) == sizeVert && prevVert != _otherTerminal &&
+                       flow[*edgeIds] > 0 &&
+                       __atomic_compare_exchange_n(&labels[prevVert], &unlabeled, prevLabel, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                        found.push_back(prevVert);
+                    }
+                }
+            }
+        });
+        frontier.clear();
+        _gatherThreadLists(frontier);
+    }
+    
+    _pool->parallelFor(vertBlocks, [&](size_t block, size_t threadIndex) {
+        vector <IndexType>& active = _threadLists[threadIndex];
+        size_t end = min(static_cast<size_t>(sizeVert), (block + 1) * vertBlockSize);
+        for(size_t vert = block * vertBlockSize;vert < end; ++vert) {
+            if(labels[vert] < sizeVert && _excess[vert] > 0 && vert != _target) {
+                active.push_back(vert);
+            }
+        }
+    });
+    _working.clear();
+    _gatherThreadLists(_working);
+}
+
+void ParallelPushRelabelFlowFinder::_runFirstPhase() {
+    Graph* graph = network->graph;
+    IndexType sizeVert = graph->sizeVert;
+    _target = network->sink;
+    _otherTerminal = network->source;
+    _label.resize(sizeVert);
+    _newLabel.resize(sizeVert);
+    _addedExcess.assign(sizeVert, 0);
+    _workingRound.assign(sizeVert, 0);
+    _discoveredRound.assign(sizeVert, 0);
+    _threadLists.resize(_pool->size());
+    _round = 0;
+    roundCount = 0;
+    
+    size_t globalRelabelWork = 6 * graph->sizeVert + graph->sizeEdge;
+    vector <IndexType> discovered;
+    _parallelGlobalRelabel();
+    while(!_working.empty()) {
+        ++_round;
+        ++roundCount;
+        for(size_t i = 0;i < _working.size(); ++i) {
+            _workingRound[_working[i]] = _round;
+        }
+        
+        std::atomic<size_t> work(0);
+        std::atomic<size_t> pushes(0);
+        std::atomic<size_t> relabels(0);
+        size_t blockSize = max(static_cast<size_t>(16), _working.size() / (_pool->size() * 16) + 1);
+        _pool->parallelFor((_working.size() + blockSize - 1) / blockSize, [&](size_t block, size_t threadIndex) {
+            size_t blockWork = 0;
+            size_t blockPushes = 0;
+            size_t blockRelabels = 0;
+            size_t end = min(_working.size(), (block + 1) * blockSize);
+            for(size_t i = block * blockSize;i < end; ++i) {
+                IndexType vert = _working[i];
+                blockWork += _parallelDischarge(vert, _threadLists[threadIndex], blockPushes);
+                blockRelabels += _newLabel[vert] != _label[vert];
+            }
+            work += blockWork;
+            pushes += blockPushes;
+            relabels += blockRelabels;
+        });
+        pushCount += pushes;
+        relabelCount += relabels;
+        _workSinceGlobalRelabel += work;
+        discovered.clear();
+        _gatherThreadLists(discovered);
+        
+        //new labels and received excess take effect; the vertices still active form the next working set
+        _excess[_target] += _addedExcess[_target];
+        _addedExcess[_target] = 0;
+        size_t keptCount = 0;
+        for(size_t i = 0;i < _working.size(); ++i) {
+            IndexType vert = _working[i];
+            _label[vert] = _newLabel[vert];
+            _excess[vert] += _addedExcess[vert];
+            _addedExcess[vert] = 0;
+            if(_excess[vert] > 0 && _label[vert] < sizeVert) {
+                _working[keptCount++] = vert;
+            }
+        }
+        _working.resize(keptCount);
+        for(size_t i = 0;i < discovered.size(); ++i) {
+            IndexType vert = discovered[i];
+            _excess[vert] += _addedExcess[vert];
+            _addedExcess[vert] = 0;
+            _working.push_back(vert);
+        }
+        if(_workSinceGlobalRelabel > globalRelabelWork) {
+            _parallelGlobalRelabel();
+        }
+    }
+}
+
+BoykovKolmogorovFlowFinder::BoykovKolmogorovFlowFinder(): augmentationCount(0), orphanCount(0) {
+}
+
+void BoykovKolmogorovFlowFinder::initFlowFinder(Network* network) {
+    this->network = network;
+    maxFlow = 0;
+    augmentationCount = 0;
+    orphanCount = 0;
+}
+
+void BoykovKolmogorovFlowFinder::_setActive(IndexType vert) {
+    if(_nextActive[vert] != UNREACHED) {
+        return;
+    }
+    if(_lastActive != UNREACHED) {
+        _nextActive[_lastActive] = vert;
+    } else {
+        _firstActive = vert;
+    }
+    _lastActive = vert;
+    _nextActive[vert] = vert;
+    _curArc[vert] = _residual.firstArc(vert);
+}
+
+IndexType BoykovKolmogorovFlowFinder::_popActive() {
+    IndexType vert = _firstActive;
+    if(vert == UNREACHED) {
+        return UNREACHED;
+    }
+    if(_nextActive[vert] == vert) {
+        _firstActive = UNREACHED;
+        _lastActive = UNREACHED;
+    } else {
+        _firstActive = _nextActive[vert];
+    }
+    _nextActive[vert] = UNREACHED;
+    return vert;
+}
+
+//free neighbours join the tree of vert; a neighbour of the same tree that was further from the root is moved
+//under vert, as long as the distances of both are from the same augmentation or the one of vert is newer
+size_t BoykovKolmogorovFlowFinder::_grow(IndexType vert) {
+    char tree = _tree[vert];
+    size_t end = _residual.arcEnd(vert);
+    size_t arc = _curArc[vert];
+    for(;arc != end; _residual.nextArc(vert, arc)) {
+        CapacityType residual = tree == TREE_SOURCE ? _residual.arcResidual(arc) : _residual.reverseResidual(arc);
+        if(residual == 0) {
+            continue;
+        }
+        IndexType nextVert = _residual.arcHead(arc);
+        if(_tree[nextVert] == TREE_FREE) {
+            _tree[nextVert] = tree;
+            _parentEdge[nextVert] = _residual.arcEdge(arc);
+            _timestamp[nextVert] = _timestamp[vert];
+            _dist[nextVert] = _dist[vert] + 1;
+            _setActive(nextVert);
+        } else if(_tree[nextVert] != tree) {
+            break;
+        } else if(_timestamp[nextVert] <= _timestamp[vert] && _dist[nextVert] > _dist[vert]) {
+            _parentEdge[nextVert] = _residual.arcEdge(arc);
+            _timestamp[nextVert] = _timestamp[vert];
+            _dist[nextVert] = _dist[vert] + 1;
+        }
+    }
+    _curArc[vert] = arc;
+    return arc;
+}
+
+void BoykovKolmogorovFlowFinder::_orphan(IndexType vert) {
+    _parentEdge[vert] = NO_PARENT;
+    _orphans.push_back(vert);
+    ++orphanCount;
+}
+
+//pushes the bottleneck along source tree path, the arc and sink tree path; saturated tree arcs orphan their child
+void BoykovKolmogorovFlowFinder::_augment(IndexType vert, size_t arc) {
+    IndexType bridge = _residual.arcEdge(arc);
+    IndexType sourceEnd = _tree[vert] == TREE_SOURCE ? vert : _residual.arcHead(arc);
+    IndexType sinkEnd = _tree[vert] == TREE_SOURCE ? _residual.arcHead(arc) : vert;
+    CapacityType bottleneck = _residualFrom(sourceEnd, bridge);
+    for(IndexType cur = sourceEnd;_parentEdge[cur] != TERMINAL_PARENT; cur = _parent(cur)) {
+        bottleneck = min(bottleneck, _residualFrom(_parent(cur), _parentEdge[cur]));
+    }
+    for(IndexType cur = sinkEnd;_parentEdge[cur] != TERMINAL_PARENT; cur = _parent(cur)) {
+        bottleneck = min(bottleneck, _residualFrom(cur, _parentEdge[cur]));
+    }
+    
+    _pushFrom(sourceEnd, bridge, bottleneck);
+    for(IndexType cur = sourceEnd;_parentEdge[cur] != TERMINAL_PARENT; ) {
+        IndexType parent = _parent(cur);
+        _pushFrom(parent, _parentEdge[cur], bottleneck);
+        if(_residualFrom(parent, _parentEdge[cur]) == 0) {
+            _orphan(cur);
+        }
+        cur = parent;
+    }
+    for(IndexType cur = sinkEnd;_parentEdge[cur] != TERMINAL_PARENT; ) {
+        IndexType parent = _parent(cur);
+        _pushFrom(cur, _parentEdge[cur], bottleneck);
+        if(_residualFrom(cur, _parentEdge[cur]) == 0) {
+            _orphan(cur);
+        }
+        cur = parent;
+    }
+    ++augmentationCount;
+}
+
+//walks up to the first vertex with a distance of this augmentation, then stamps the walked path
+IndexType BoykovKolmogorovFlowFinder::_rootDist(IndexType vert) {
+    IndexType dist = 0;
+    IndexType cur = vert;
+    while(_timestamp[cur] != _time) {
+        if(_parentEdge[cur] == NO_PARENT) {
+            return UNREACHED;
+        }
+        if(_parentEdge[cur] == TERMINAL_PARENT) {
+            _timestamp[cur] = _time;
+            _dist[cur] = 0;
+            break;
+        }
+        ++dist;
+        cur = _parent(cur);
+    }
+    dist += _dist[cur];
+    IndexType result = dist;
+    for(cur = vert;_timestamp[cur] != _time; cur = _parent(cur)) {
+        _timestamp[cur] = _time;
+        _dist[cur] = dist--;
+    }
+    return result;
+}
+
+void BoykovKolmogorovFlowFinder::_adopt(IndexType orphan) {
+    char tree = _tree[orphan];
+    IndexType bestEdge = NO_PARENT;
+    IndexType bestDist = UNREACHED;
+    size_t end = _residual.arcEnd(orphan);
+    for(size_t arc = _residual.firstArc(orphan);arc != end; _residual.nextArc(orphan, arc)) {
+        CapacityType residual = tree == TREE_SOURCE ? _residual.reverseResidual(arc) : _residual.arcResidual(arc);
+        IndexType nextVert = _residual.arcHead(arc);
+        if(residual == 0 || _tree[nextVert] != tree) {
+            continue;
+        }
+        IndexType dist = _rootDist(nextVert);
+        if(dist < bestDist) {
+            bestDist = dist;
+            bestEdge = _residual.arcEdge(arc);
+        }
+    }
+    if(bestEdge != NO_PARENT) {
+        _parentEdge[orphan] = bestEdge;
+        _timestamp[orphan] = _time;
+        _dist[orphan] = bestDist + 1;
+        return;
+    }
+    
+    //no way back to the root: neighbours that could take the orphan in grow again, its children are orphans
+    for(size_t arc = _residual.firstArc(orphan);arc != end; _residual.nextArc(orphan, arc)) {
+        IndexType nextVert = _residual.arcHead(arc);
+        if(_tree[nextVert] != tree) {
+            continue;
+        }
+        CapacityType residual = tree == TREE_SOURCE ? _residual.arcResidual(arc) : _residual.reverseResidual(arc);
+        if(residual > 0) {
+            _setActive(nextVert);
+        }
+        IndexType parentEdge = _parentEdge[nextVert];
+        if(parentEdge != NO_PARENT && parentEdge != TERMINAL_PARENT && _parent(nextVert) == orphan) {
+            _orphan(nextVert);
+        }
+    }
+    _tree[orphan] = TREE_FREE;
+}
+
+void BoykovKolmogorovFlowFinder::getMaxFlow() {
+    Graph* graph = network->graph;
+    size_t sizeVert = graph->sizeVert;
+    size_t source = network->source;
+    size_t sink = network->sink;
+    _residual.init(network);
+    _tree.assign(sizeVert, TREE_FREE);
+    _parentEdge.assign(sizeVert, NO_PARENT);
+    _dist.assign(sizeVert, 0);
+    _timestamp.assign(sizeVert, 0);
+    _curArc.resize(sizeVert);
+    _nextActive.assign(sizeVert, UNREACHED);
+    _firstActive = UNREACHED;
+    _lastActive = UNREACHED;
+    _orphans.clear();
+    _time = 0;
+    
+    _tree[source] = TREE_SOURCE;
+    _tree[sink] = TREE_SINK;
+    _parentEdge[source] = TERMINAL_PARENT;
+    _parentEdge[sink] = TERMINAL_PARENT;
+    _setActive(source);
+    _setActive(sink);
+    IndexType growing = UNREACHED;
+    while(true) {
+        if(growing == UNREACHED || _tree[growing] == TREE_FREE) {
+            growing = _popActive();
+            if(growing == UNREACHED) {
+                break;
+            }
+            continue;
+        }
+        size_t arc = _grow(growing);
+        if(arc == _residual.arcEnd(growing)) {
+            growing = UNREACHED;
+            continue;
+        }
+        //the vertex keeps growing after the augmentation: its arcs before arc have nothing left to give
+        ++_time;
+        _augment(growing, arc);
+        for(size_t i = 0;i < _orphans.size(); ++i) {
+            _adopt(_orphans[i]);
+        }
+        _orphans.clear();
+    }
+    
+    //flow leaving the source, also counts flow the network carried before
+    maxFlow = _residual.netOutflow(source);
+    _sourceSide.resize(sizeVert);
+    for(size_t vert = 0;vert < sizeVert; ++vert) {
+        _sourceSide[vert] = _tree[vert] == TREE_SOURCE;
+    }
+}
+
+void BoykovKolmogorovFlowFinder::getMinCut(MinCut& cut) {
+    cut.build(network, _sourceSide);
+}
+
+PseudoflowFlowFinder::PseudoflowFlowFinder(): mergeCount(0), relabelCount(0), liftCount(0) {
+}
+
+void PseudoflowFlowFinder::initFlowFinder(Network* network) {
+    this->network = network;
+    maxFlow = 0;
+    mergeCount = 0;
+    relabelCount = 0;
+    liftCount = 0;
+}
+
+void PseudoflowFlowFinder::_addStrongRoot(IndexType vert) {
+    IndexType label = _label[vert];
+    _nextRoot[vert] = _rootHead[label];
+    _rootHead[label] = vert;
+    _lowestLabel = min(_lowestLabel, label);
+}
+
+void PseudoflowFlowFinder::_addChild(IndexType parent, IndexType child, IndexType edge) {
+    _parent[child] = parent;
+    _parentEdge[child] = edge;
+    _prevSibling[child] = UNREACHED;
+    _nextSibling[child] = _firstChild[parent];
+    if(_firstChild[parent] != UNREACHED) {
+        _prevSibling[_firstChild[parent]] = child;
+    }
+    _firstChild[parent] = child;
+}
+
+void PseudoflowFlowFinder::_removeChild(IndexType child) {
+    IndexType parent = _parent[child];
+    if(_prevSibling[child] != UNREACHED) {
+        _nextSibling[_prevSibling[child]] = _nextSibling[child];
+    } else {
+        _firstChild[parent] = _nextSibling[child];
+    }
+    if(_nextSibling[child] != UNREACHED) {
+        _prevSibling[_nextSibling[child]] = _prevSibling[child];
+    }
+    //a depth-first search in the parent may be about to go on with this child
+    if(_nextScan[parent] == child) {
+        _nextScan[parent] = _nextSibling[child];
+    }
+    _parent[child] = UNREACHED;
+}
+
+void PseudoflowFlowFinder::_setLabel(IndexType vert, IndexType label) {
+    --_labelCount[_label[vert]];
+    _label[vert] = label;
+    ++_labelCount[label];
+}
+
+//a residual arc from vert to a vertex one label lower; vertices of label _lowestLabel - 1 are all weak
+bool PseudoflowFlowFinder::_findMerger(IndexType vert, size_t& arc) {
+    IndexType weakLabel = _label[vert] - 1;
+    size_t end = _residual.arcEnd(vert);
+    for(arc = _curArc[vert];arc != end; _residual.nextArc(vert, arc)) {
+        if(_label[_residual.arcHead(arc)] == weakLabel && _residual.arcResidual(arc) > 0) {
+            _curArc[vert] = arc;
+            return true;
+        }
+    }
+    _curArc[vert] = end;
+    return false;
+}
+
+//moves _nextScan to the next child with the label of vert; when there is none, vert is done and relabeled
+void PseudoflowFlowFinder::_checkChildren(IndexType vert) {
+    for(;_nextScan[vert] != UNREACHED; _nextScan[vert] = _nextSibling[_nextScan[vert]]) {
+        if(_label[_nextScan[vert]] == _label[vert]) {
+            return;
+        }
+    }
+    _setLabel(vert, _label[vert] + 1);
+    _curArc[vert] = _residual.firstArc(vert);
+    ++relabelCount;
+}
+
+//hangs the strong tree of root below the head of arc by reversing the tree path from strongVert up to root
+void PseudoflowFlowFinder::_merge(IndexType root, IndexType strongVert, size_t arc) {
+    IndexType newParent = _residual.arcHead(arc);
+    IndexType newEdge = _residual.arcEdge(arc);
+    IndexType cur = strongVert;
+    while(cur != root) {
+        IndexType oldParent = _parent[cur];
+        IndexType oldEdge = _parentEdge[cur];
+        _removeChild(cur);
+        _addChild(newParent, cur, newEdge);
+        newParent = cur;
+        newEdge = oldEdge;
+        cur = oldParent;
+    }
+    _addChild(newParent, root, newEdge);
+    ++mergeCount;
+}
+
+//pushes the excess of the old strong root up to the new root; a vertex whose arc to its parent saturates keeps the
+//rest of its excess and becomes a strong root
+void PseudoflowFlowFinder::_pushExcess(IndexType root) {
+    IndexType cur = root;
+    for(;_excess[cur] > 0 && _parent[cur] != UNREACHED; ) {
+        IndexType parent = _parent[cur];
+        IndexType edge = _parentEdge[cur];
+        CapacityType residual = _residualFrom(cur, edge);
+        if(residual >= _excess[cur]) {
+            _pushFrom(cur, edge, static_cast<CapacityType>(_excess[cur]));
+            _excess[parent] += _excess[cur];
+            _excess[cur] = 0;
+        } else {
+            _pushFrom(cur, edge, residual);
+            _excess[parent] += residual;
+            _excess[cur] -= residual;
+            _removeChild(cur);
+            _addStrongRoot(cur);
+        }
+        cur = parent;
+    }
+    //the weak root took all of it, or turned strong
+    if(_parent[cur] == UNREACHED && _excess[cur] > 0) {
+        _addStrongRoot(cur);
+    }
+}
+
+//depth-first search through the vertices of the root's label for a merger arc, relabeling each vertex it leaves
+void PseudoflowFlowFinder::_processRoot(IndexType root) {
+    size_t arc;
+    IndexType vert = root;
+    _nextScan[root] = _firstChild[root];
+    if(_findMerger(root, arc)) {
+        _merge(root, root, arc);
+        _pushExcess(root);
+        return;
+    }
+    _checkChildren(root);
+    while(vert != UNREACHED) {
+        while(_nextScan[vert] != UNREACHED) {
+            IndexType child = _nextScan[vert];
+            _nextScan[vert] = _nextSibling[child];
+            vert = child;
+            _nextScan[vert] = _firstChild[vert];
+            if(_findMerger(vert, arc)) {
+                _merge(root, vert, arc);
+                _pushExcess(root);
+                return;
+            }
+            _checkChildren(vert);
+        }
+        if(vert == root) {
+            break;
+        }
+        vert = _parent[vert];
+        _checkChildren(vert);
+    }
+    if(_label[root] < network->graph->sizeVert) {
+        _addStrongRoot(root);
+    }
+}
+
+//every vertex of the tree of root gets label V: it is on the source side
+void PseudoflowFlowFinder::_liftAll(IndexType root) {
+    IndexType sizeVert = network->graph->sizeVert;
+    ++liftCount;
+    _stack.clear();
+    _stack.push_back(root);
+    while(!_stack.empty()) {
+        IndexType vert = _stack.back();
+        _stack.pop_back();
+        _setLabel(vert, sizeVert);
+        for(IndexType child = _firstChild[vert];child != UNREACHED; child = _nextSibling[child]) {
+            _stack.push_back(child);
+        }
+    }
+}
+
+//deficits come off the arcs into the sink; excesses go back to the source along arcs that carry flow into the
+//vertex, a path at a time, cancelling flow cycles met on the way. _curArc is reused as position in incomingList
+void PseudoflowFlowFinder::_returnExcess() {
+    Graph* graph = network->graph;
+    size_t sizeVert = graph->sizeVert;
+    size_t source = network->source;
+    size_t sink = network->sink;
+    CapacityType* flow = _residual.flow;
+    for(size_t vert = 0;vert < sizeVert; ++vert) {
+        for(size_t i = graph->outgoingList.offsets[vert];_excess[vert] < 0 && i < graph->outgoingList.offsets[vert + 1]; ++i) {
+            IndexType edge = graph->outgoingList.edgeIds[i];
+            if(graph->edgeFinish[edge] == sink) {
+                CapacityType returned = -_excess[vert] < flow[edge] ? static_cast<CapacityType>(-_excess[vert]) : flow[edge];
+                flow[edge] -= returned;
+                _excess[vert] += returned;
+            }
+        }
+    }
+    
+    //_stack holds the path as vertices, _nextScan[v] is the edge into v on it, _nextRoot marks the vertices on it
+    for(size_t vert = 0;vert < sizeVert; ++vert) {
+        _curArc[vert] = graph->incomingList.offsets[vert];
+        _nextRoot[vert] = UNREACHED;
+    }
+    for(size_t start = 0;start < sizeVert; ++start) {
+        if(start == source || start == sink) {
+            continue;
+        }
+        while(_excess[start] > 0) {
+            _stack.clear();
+            _stack.push_back(start);
+            _nextRoot[start] = 0;
+            while(_stack.back() != source) {
+                IndexType vert = _stack.back();
+                IndexType edge;
+                while(flow[edge = graph->incomingList.edgeIds[_curArc[vert]]] == 0) {
+                    ++_curArc[vert];
+                }
+                IndexType prevVert = graph->edgeStart[edge];
+                _nextScan[vert] = edge;
+                if(_nextRoot[prevVert] == UNREACHED) {
+                    _nextRoot[prevVert] = 0;
+                    _stack.push_back(prevVert);
+                    continue;
+                }
+                //cycle from prevVert through the top of the path: cancel its smallest flow
+                size_t first = _stack.size() - 1;
+                while(_stack[first] != prevVert) {
+                    --first;
+                }
+                CapacityType cancelled = flow[edge];
+                for(size_t i = first + 1;i < _stack.size(); ++i) {
+                    cancelled = min(cancelled, flow[_nextScan[_stack[i - 1]]]);
+                }
+                for(size_t i = first;i < _stack.size(); ++i) {
+                    flow[_nextScan[_stack[i]]] -= cancelled;
+                }
+                for(size_t i = first + 1;i < _stack.size(); ++i) {
+                    _nextRoot[_stack[i]] = UNREACHED;
+                }
+                _stack.resize(first + 1);
+            }
+            CapacityType returned = _excess[start] < flow[_nextScan[start]] ? static_cast<CapacityType>(_excess[start]) : flow[_nextScan[start]];
+            for(size_t i = 0;i + 1 < _stack.size(); ++i) {
+                returned = min(returned, flow[_nextScan[_stack[i]]]);
+            }
+            for(size_t i = 0;i + 1 < _stack.size(); ++i) {
+                flow[_nextScan[_stack[i]]] -= returned;
+                _nextRoot[_stack[i]] = UNREACHED;
+            }
+            _nextRoot[source] = UNREACHED;
+            _excess[start] -= returned;
+        }
+    }
+}
+
+void PseudoflowFlowFinder::getMaxFlow() {
+    Graph* graph = network->graph;
+    IndexType sizeVert = graph->sizeVert;
+    size_t source = network->source;
+    size_t sink = network->sink;
+    _residual.init(network);
+    _excess.assign(sizeVert, 0);
+    _label.assign(sizeVert, 1);
+    _labelCount.assign(sizeVert + 1, 0);
+    _curArc.resize(sizeVert);
+    _parent.assign(sizeVert, UNREACHED);
+    _parentEdge.resize(sizeVert);
+    _firstChild.assign(sizeVert, UNREACHED);
+    _nextSibling.resize(sizeVert);
+    _prevSibling.resize(sizeVert);
+    _nextScan.assign(sizeVert, UNREACHED);
+    _rootHead.assign(sizeVert + 1, UNREACHED);
+    _nextRoot.resize(sizeVert);
+    _lowestLabel = sizeVert;
+    
+    //terminals get label V, so they are never merger arc heads, and stay out of the forest
+    _label[source] = sizeVert;
+    _label[sink] = sizeVert;
+    _labelCount[1] = sizeVert - 2;
+    //excess of the flow we start with, zero unless the network already carries flow, then the terminal arcs
+    for(size_t i = 0;i < graph->sizeEdge; ++i) {
+        IndexType start = graph->edgeStart[i];
+        IndexType finish = graph->edgeFinish[i];
+        if(start == finish) {
+            continue;
+        }
+        if((start == source || finish == sink) && finish != source && start != sink) {
+            _residual.flow[i] = graph->edgeCapacity[i];
+        }
+        _excess[finish] += _residual.flow[i];
+        _excess[start] -= _residual.flow[i];
+    }
+    for(IndexType vert = 0;vert < sizeVert; ++vert) {
+        _curArc[vert] = _residual.firstArc(vert);
+        if(vert != source && vert != sink && _excess[vert] > 0) {
+            _addStrongRoot(vert);
+        }
+    }
+    
+    while(true) {
+        while(_lowestLabel < sizeVert && _rootHead[_lowestLabel] == UNREACHED) {
+            ++_lowestLabel;
+        }
+        if(_lowestLabel >= sizeVert) {
+            break;
+        }
+        IndexType root = _rootHead[_lowestLabel];
+        _rootHead[_lowestLabel] = _nextRoot[root];
+        if(_lowestLabel > 1 && _labelCount[_lowestLabel - 1] == 0) {
+            _liftAll(root);
+        } else {
+            _processRoot(root);
+        }
+    }
+    
+    _sourceSide.resize(sizeVert);
+    for(IndexType vert = 0;vert < sizeVert; ++vert) {
+        _sourceSide[vert] = vert == source || (vert != sink && _label[vert] == sizeVert);
+    }
+    _excess[source] = 0;
+    _excess[sink] = 0;
+    _returnExcess();
+    maxFlow = _residual.netOutflow(source);
+}
+
+void PseudoflowFlowFinder::getMinCut(MinCut& cut) {
+    cut.build(network, _sourceSide);
+}
+
+CapacityType uniformCapacity(Graph* graph) {
+    if(graph->sizeEdge == 0) {
+        return 0;
+    }
+    CapacityType capacity = graph->edgeCapacity[0];
+    for(size_t i = 1;i < graph->sizeEdge; ++i) {
+        if(graph->edgeCapacity[i] != capacity) {
+            return 0;
+        }
+    }
+    return capacity;
+}
+
+UnitCapacityFlowFinder::UnitCapacityFlowFinder(): phaseCount(0) {
+}
+
+void UnitCapacityFlowFinder::initFlowFinder(Network* network) {
+    this->network = network;
+    maxFlow = 0;
+    phaseCount = 0;
+}
+
+//distances to the sink over usable arcs, vertices at or past the distance of the source aren't expanded
+bool UnitCapacityFlowFinder::_runBfs() {
+    size_t source = network->source;
+    size_t sink = network->sink;
+    _dist.assign(network->graph->sizeVert, UNREACHED);
+    _queue.clear();
+    _dist[sink] = 0;
+    _queue.push_back(sink);
+    for(size_t i = 0;i < _queue.size() && _dist[source] == UNREACHED; ++i) {
+        IndexType vert = _queue[i];
+        IndexType prevDist = _dist[vert] + 1;
+        size_t end = _residual.arcEnd(vert);
+        for(size_t arc = _residual.firstArc(vert);arc != end; _residual.nextArc(vert, arc)) {
+            IndexType prevVert = _residual.arcHead(arc);
+            if(_dist[prevVert] == UNREACHED && _isReverseUsable(arc)) {
+                _dist[prevVert] = prevDist;
+                _queue.push_back(prevVert);
+            }
+        }
+    }
+    return _dist[source] != UNREACHED;
+}
+
+size_t UnitCapacityFlowFinder::_findBlockFlow() {
+    size_t source = network->source;
+    size_t sink = network->sink;
+    size_t sizeVert = network->graph->sizeVert;
+    _curArc.resize(sizeVert);
+    for(size_t i = 0;i < _queue.size(); ++i) {
+        _curArc[_queue[i]] = _residual.firstArc(_queue[i]);
+    }
+    _path.clear();
+    
+    size_t pathCount = 0;
+    size_t vert = source;
+    while(true) {
+        if(vert == sink) {
+            //every arc of the path is saturated, the search starts over from the source
+            for(size_t i = 0;i < _path.size(); ++i) {
+                _flip(_path[i]);
+            }
+            ++pathCount;
+            _path.clear();
+            vert = source;
+            continue;
+        }
+        size_t end = _residual.arcEnd(vert);
+        IndexType nextDist = _dist[vert] - 1;
+        size_t& arc = _curArc[vert];
+        while(arc != end && !(_dist[_residual.arcHead(arc)] == nextDist && _isUsable(arc))) {
+            _residual.nextArc(vert, arc);
+        }
+        if(arc != end) {
+            _path.push_back(arc);
+            vert = _residual.arcHead(arc);
+        } else if(vert == source) {
+            break;
+        } else {
+            //dead end: no arc of the level graph leads here any more
+            _dist[vert] = UNREACHED;
+            _path.pop_back();
+            vert = _path.empty() ? source : _residual.arcHead(_path.back());
+        }
+    }
+    return pathCount;
+}
+
+void UnitCapacityFlowFinder::getMaxFlow() {
+    Graph* graph = network->graph;
+    _residual.init(network);
+    _capacity = uniformCapacity(graph);
+    _full.assign((graph->sizeEdge + 63) / 64, 0);
+    for(size_t i = 0;i < graph->sizeEdge; ++i) {
+        if(_residual.flow[i] != 0) {
+            _full[i >> 6] |= static_cast<uint64_t>(1) << (i & 63);
+        }
+    }
+    
+    while(_runBfs()) {
+        _findBlockFlow();
+        ++phaseCount;
+    }
+    for(size_t i = 0;i < graph->sizeEdge; ++i) {
+        _residual.flow[i] = _isFull(i) ? _capacity : 0;
+    }
+    maxFlow = _residual.netOutflow(network->source);
+}
+
+void UnitCapacityFlowFinder::getMinCut(MinCut& cut) {
+    vector <bool> sourceSide(network->graph->sizeVert, true);
+    for(size_t i = 0;i < _queue.size(); ++i) {
+        sourceSide[_queue[i]] = false;
+    }
+    cut.build(network, sourceSide);
+}
+
+//bfs of a phase, dist then labels the level graph: false if the sink is unreachable
+bool DinicFlowFinder::runLevelBfs() {
+    bfs.init(network);
+    bfs.stopAtSinkLevel = pruneLevelGraph;
+    bfs.minResidual = minResidual;
+    bool sinkReached = bfs.run();
+    ++phaseCount;
+    bfsEdgesExamined += bfs.edgesExamined;
+    if(!sinkReached) {
+        return false;
+    }
+    if(countLevelArcs) {
+        levelArcCounts.push_back(0);
+    }
+    if(pruneLevelGraph) {
+        bfs.pruneDeadEnds();
+    }
+    if(countLevelArcs) {
+        levelArcCounts.back() = countAdmissibleArcs();
+    }
+    return true;
+}
+
+size_t DinicFlowFinder::countAdmissibleArcs() {
+    const vector <IndexType>& dist = *bfs.dist;
+    Graph* graph = network->graph;
+    size_t arcCount = 0;
+    for(size_t i = 0;i < graph->sizeEdge; ++i) {
+        IndexType start = graph->edgeStart[i];
+        IndexType finish = graph->edgeFinish[i];
+        if(dist[start] == UNREACHED || dist[finish] == UNREACHED) {
+            continue;
+        }
+        if(dist[start] + 1 == dist[finish] && graph->edgeCapacity[i] - network->flow[i] >= minResidual && start != network->sink) {
+            ++arcCount;
+        }
+        if(dist[finish] + 1 == dist[start] && network->flow[i] >= minResidual && finish != network->sink) {
+            ++arcCount;
+        }
+    }
+    return arcCount;
+}
+
+bool DinicFlowFinder::getLevelGraph() {
+    if(!runLevelBfs()) {
+        return false;
+    }
+    levelGraph.init(network, *bfs.dist, minResidual);
+    return true;
+}
+
+bool DinicFlowFinder::getShortPathNetwork() {
+    EdgeColumns shortPathEdges;
+    vector <IndexType>* edgeID = new vector <IndexType>;
+    
+    if(!runLevelBfs()) {
+        delete edgeID;
+        return false;
+    }
+    
+    DirectEdge curEdge;
+    Graph* graph = network->graph;
+    for(size_t i = 0;i < graph->sizeEdge; ++i) {
+        curEdge = graph->edge(i);
+        if(checkEdgeForShortPath(i, curEdge)) {
+            edgeID->push_back(i);
+            shortPathEdges.push_back(curEdge);
+        }
+    }
+    
+    shortPathNetwork = new ShortPathNetwork(new Graph(network->graph->sizeVert, shortPathEdges),
+                                            network->source, network->sink, *edgeID);
+    return true;
+}
+
+bool DinicFlowFinder::checkEdgeForShortPath(size_t edgeNumber, DirectEdge& edge) {
+    if((*bfs.dist)[edge.start] == UNREACHED || (*bfs.dist)[edge.finish] == UNREACHED) {
+        return false;
+    }
+    
+    if((*bfs.dist)[edge.start] + 1 == (*bfs.dist)[edge.finish] && edge.capacity - network->flow[edgeNumber] >= minResidual
+       && edge.start != network->sink) {
+        edge.capacity -= network->flow[edgeNumber];
+        return true;
+    }
+    
+    if((*bfs.dist)[edge.finish] + 1 == (*bfs.dist)[edge.start] &&  network->flow[edgeNumber] >= minResidual && edge.finish != network->sink) {
+        std::swap(edge.start, edge.finish);
+        edge.capacity = network->flow[edgeNumber];
+        return true;
+    }
+    
+    return false;
+}
+
+Bfs::Bfs() {
+    used = nullptr;
+    dist = nullptr;
+    mode = BFS_HYBRID;
+    edgesExamined = 0;
+    stopAtSinkLevel = false;
+    minResidual = 1;
+    pool = nullptr;
+}
+
+Bfs::~Bfs() {
+    delete used;
+    delete dist;
+}
+
+void Bfs::init(Network* network) {
+    size_t sizeVert = network->graph->sizeVert;
+    if(!used) {
+        used = new vector <bool> (sizeVert);
+        dist = new vector <IndexType> (sizeVert);
+    }
+    
+    used->assign(sizeVert, false);
+    dist->assign(sizeVert, UNREACHED);
+    this->network = network;
+    edgesExamined = 0;
+}
+
+void Bfs::checkOutgoingEdges(size_t vert, size_t levelDist) {
+    const IndexType* edgeIds = graph->outgoingList.edgeIds.begin();
+    const IndexType* edgeIdsEnd = edgeIds + graph->outgoingList.offsets[vert + 1];
+    vector <bool>& usedRef = *used;
+    vector <CapacityType>& flow = network->flow;
+    edgesExamined += graph->outgoingList.degree(vert);
+    for(edgeIds += graph->outgoingList.offsets[vert];edgeIds != edgeIdsEnd;++edgeIds) {
+        IndexType nextVert = graph->edgeFinish[*edgeIds];
+        if(!usedRef[nextVert] && graph->edgeCapacity[*edgeIds] - flow[*edgeIds] >= minResidual) {
+            usedRef[nextVert] = true;
+            (*dist)[nextVert] = levelDist;
+            bfsQueue.push(std::make_pair(nextVert, levelDist));
+        }
+    }
+}
+
+void Bfs::checkIncomingEdges(size_t vert, size_t levelDist) {
+    const IndexType* edgeIds = graph->incomingList.edgeIds.begin();
+    const IndexType* edgeIdsEnd = edgeIds + graph->incomingList.offsets[vert + 1];
+    vector <bool>& usedRef = *used;
+    vector <CapacityType>& flow = network->flow;
+    edgesExamined += graph->incomingList.degree(vert);
+    for(edgeIds += graph->incomingList.offsets[vert];edgeIds != edgeIdsEnd;++edgeIds) {
+        IndexType nextVert = graph->edgeStart[*edgeIds];
+        if(!usedRef[nextVert] && flow[*edgeIds] >= minResidual) {
+            usedRef[nextVert] = true;
+            (*dist)[nextVert] = levelDist;
+            bfsQueue.push(std::make_pair(nextVert, levelDist));
+        }
+    }
+}
+
+bool Bfs::run() {
+    size_t vert;
+    size_t levelDist;
+    
+    graph = network->graph;
+    source = network->source;
+    sink = network->sink;
+    
+    if(mode != BFS_TOP_DOWN) {
+        return runHybrid();
+    }
+    
+    (*dist)[source] = 0;
+    (*used)[source] = true;
+    bfsQueue.push(std::make_pair(source, 0));
+    
+    while(!bfsQueue.empty()) {
+        vert = bfsQueue.front().first;
+        levelDist = bfsQueue.front().second;
+        bfsQueue.pop();
+        
+        if(vert == sink || (stopAtSinkLevel && (*dist)[sink] <= levelDist)) {
+            continue;
+        }
+        
+        ++levelDist;
+        
+        checkOutgoingEdges(vert, levelDist);
+        checkIncomingEdges(vert, levelDist);
+    }
+    
+    return (*used)[sink];
+}
+
+void Bfs::visit(IndexType vert, IndexType levelDist, size_t& frontierEdges) {
+    (*used)[vert] = true;
+    (*dist)[vert] = levelDist;
+    nextFrontier.push_back(vert);
+    frontierEdges += degree(vert);
+}
+
+size_t Bfs::topDownStep(IndexType level) {
+    vector <bool>& usedRef = *used;
+    const CapacityType* flow = &network->flow[0];
+    size_t frontierEdges = 0;
+    for(size_t i = 0;i < frontier.size(); ++i) {
+        IndexType vert = frontier[i];
+        if(vert == sink) {
+            continue;
+        }
+        const IndexType* edgeIds = graph->outgoingList.edgeIds.begin();
+        const IndexType* edgeIdsEnd = edgeIds + graph->outgoingList.offsets[vert + 1];
+        for(edgeIds += graph->outgoingList.offsets[vert];edgeIds != edgeIdsEnd;++edgeIds) {
+            IndexType nextVert = graph->edgeFinish[*edgeIds];
+            if(!usedRef[nextVert] && graph->edgeCapacity[*edgeIds] - flow[*edgeIds] >= minResidual) {
+                visit(nextVert, level + 1, frontierEdges);
+            }
+        }
+        edgeIds = graph->incomingList.edgeIds.begin();
+        edgeIdsEnd = edgeIds + graph->incomingList.offsets[vert + 1];
+        for(edgeIds += graph->incomingList.offsets[vert];edgeIds != edgeIdsEnd;++edgeIds) {
+            IndexType nextVert = graph->edgeStart[*edgeIds];
+            if(!usedRef[nextVert] && flow[*edgeIds] >= minResidual) {
+                visit(nextVert, level + 1, frontierEdges);
+            }
+        }
+        edgesExamined += degree(vert);
+    }
+    return frontierEdges;
+}
+
+//true if vert has a residual edge from a frontier vertex other than the sink; stops at the first one.
+//dist is read atomically, BFS_PARALLEL sets it for other vertices meanwhile
+bool Bfs::hasParent(IndexType vert, IndexType level, size_t& examined) {
+    IndexType* distRef = &(*dist)[0];
+    const CapacityType* flow = &network->flow[0];
+    const IndexType* edgeIds = graph->incomingList.edgeIds.begin() + graph->incomingList.offsets[vert];
+    const IndexType* edgeIdsEnd = graph->incomingList.edgeIds.begin() + graph->incomingList.offsets[vert + 1];
+    for(;edgeIds != edgeIdsEnd; ++edgeIds) {
+        ++examined;
+        IndexType prevVert = graph->edgeStart[*edgeIds];
+        if(__atomic_load_n(&distRef[prevVert], __ATOMIC_RELAXED) == level && prevVert != sink && graph->edgeCapacity[*edgeIds] - flow[*edgeIds] >= minResidual) {
+            return true;
+        }
+    }
+    edgeIds = graph->outgoingList.edgeIds.begin() + graph->outgoingList.offsets[vert];
+    edgeIdsEnd = graph->outgoingList.edgeIds.begin() + graph->outgoingList.offsets[vert + 1];
+    for(;edgeIds != edgeIdsEnd; ++edgeIds) {
+        ++examined;
+        IndexType prevVert = graph->edgeFinish[*edgeIds];
+        if(__atomic_load_n(&distRef[prevVert], __ATOMIC_RELAXED) == level && prevVert != sink && flow[*edgeIds] >= minResidual) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Bfs::bottomUpStep(IndexType level) {
+    size_t frontierEdges = 0;
+    for(size_t vert = 0;vert < graph->sizeVert; ++vert) {
+        if(!(*used)[vert] && hasParent(vert, level, edgesExamined)) {
+            visit(vert, level + 1, frontierEdges);
+        }
+    }
+    return frontierEdges;
+}
+
+//the thread that sets the visited bit of vert gets true, sets its dist and adds it to its frontier part
+bool Bfs::claim(IndexType vert, IndexType levelDist) {
+    uint64_t bit = static_cast<uint64_t>(1) << (vert & 63);
+    if(__atomic_fetch_or(&visitedBits[vert >> 6], bit, __ATOMIC_RELAXED) & bit) {
+        return false;
+    }
+    __atomic_store_n(&(*dist)[vert], levelDist, __ATOMIC_RELAXED);
+    return true;
+}
+
+size_t Bfs::parallelTopDownStep(IndexType level) {
+    const CapacityType* flow = &network->flow[0];
+    std::atomic<size_t> frontierEdges(0);
+    std::atomic<size_t> examined(0);
+    size_t blockSize = max(static_cast<size_t>(256), frontier.size() / (pool->size() * 8) + 1);
+    pool->parallelFor((frontier.size() + blockSize - 1) / blockSize, [&](size_t block, size_t threadIndex) {
+        vector <IndexType>& found = threadFrontiers[threadIndex];
+        size_t foundEdges = 0;
+        size_t blockExamined = 0;
+        size_t end = min(frontier.size(), (block + 1) * blockSize);
+        for(size_t i = block * blockSize;i < end; ++i) {
+            IndexType vert = frontier[i];
+            if(vert == sink) {
+                continue;
+            }
+            const IndexType* edgeIds = graph->outgoingList.edgeIds.begin();
+            const IndexType* edgeIdsEnd = edgeIds + graph->outgoingList.offsets[vert + 1];
+            for(edgeIds += graph->outgoingList.offsets[vert];edgeIds != edgeIdsEnd;++edgeIds) {
+                IndexType nextVert = graph->edgeFinish[*edgeIds];
+                if(isUnreached(nextVert) && graph->edgeCapacity[*edgeIds] - flow[*edgeIds] >= minResidual && claim(nextVert, level + 1)) {
+                    found.push_back(nextVert);
+                    foundEdges += degree(nextVert);
+                }
+            }
+            edgeIds = graph->incomingList.edgeIds.begin();
+            edgeIdsEnd = edgeIds + graph->incomingList.offsets[vert + 1];
+            for(edgeIds += graph->incomingList.offsets[vert];edgeIds != edgeIdsEnd;++edgeIds) {
+                IndexType nextVert = graph->edgeStart[*edgeIds];
+                if(isUnreached(nextVert) && flow[*edgeIds] >= minResidual && claim(nextVert, level + 1)) {
+                    found.push_back(nextVert);
+                    foundEdges += degree(nextVert);
+                }
+            }
+            blockExamined += degree(vert);
+        }
+        frontierEdges += foundEdges;
+        examined += blockExamined;
+    });
+    edgesExamined += examined;
+    return frontierEdges;
+}
+
+//every vertex is tested by one thread only and blocks cover whole words of visitedBits, so no claiming is needed
+size_t Bfs::parallelBottomUpStep(IndexType level) {
+    IndexType* distRef = &(*dist)[0];
+    std::atomic<size_t> frontierEdges(0);
+    std::atomic<size_t> examined(0);
+    const size_t blockSize = 4096;
+    pool->parallelFor((graph->sizeVert + blockSize - 1) / blockSize, [&](size_t block, size_t threadIndex) {
+        vector <IndexType>& found = threadFrontiers[threadIndex];
+        size_t foundEdges = 0;
+        size_t blockExamined = 0;
+        size_t end = min(static_cast<size_t>(graph->sizeVert), (block + 1) * blockSize);
+        for(size_t vert = block * blockSize;vert < end; ++vert) {
+            if(isUnreached(vert) && hasParent(vert, level, blockExamined)) {
+                visitedBits[vert >> 6] |= static_cast<uint64_t>(1) << (vert & 63);
+                __atomic_store_n(&distRef[vert], level + 1, __ATOMIC_RELAXED);
+                found.push_back(vert);
+                foundEdges += degree(vert);
+            }
+        }
+        frontierEdges += foundEdges;
+        examined += blockExamined;
+    });
+    edgesExamined += examined;
+    return frontierEdges;
+}
+
+//moves the per-thread parts of the next frontier into nextFrontier
+size_t Bfs::gatherNextFrontier() {
+    for(size_t i = 0;i < threadFrontiers.size(); ++i) {
+        nextFrontier.insert(nextFrontier.end(), threadFrontiers[i].begin(), threadFrontiers[i].end());
+        threadFrontiers[i].clear();
+    }
+    return nextFrontier.size();
+}
+
+//level-synchronous bfs switching between top-down and bottom-up steps by the frontier size, the heuristic of
+//Beamer et al.: bottom-up once a growing frontier has more than 1/14 of the unexplored edges, back to top-down
+//once it holds less than 1/24 of the vertices
+bool Bfs::runHybrid() {
+    const size_t topDownToBottomUp = 14;
+    const size_t bottomUpToTopDown = 24;
+    
+    bool parallel = mode == BFS_PARALLEL && pool;
+    if(parallel) {
+        threadFrontiers.resize(pool->size());
+        visitedBits.assign((graph->sizeVert + 63) / 64, 0);
+        visitedBits[source >> 6] |= static_cast<uint64_t>(1) << (source & 63);
+    }
+    frontier.clear();
+    nextFrontier.clear();
+    size_t frontierEdges = 0;
+    visit(source, 0, frontierEdges);
+    size_t unexploredEdges = 2 * graph->sizeEdge - frontierEdges;
+    bool bottomUp = false;
+    for(IndexType level = 0;!nextFrontier.empty() && !(stopAtSinkLevel && (*dist)[sink] != UNREACHED); ++level) {
+        bool growing = nextFrontier.size() > frontier.size();
+        frontier.swap(nextFrontier);
+        nextFrontier.clear();
+        if(!bottomUp) {
+            bottomUp = growing && frontierEdges > unexploredEdges / topDownToBottomUp;
+        } else {
+            bottomUp = frontier.size() >= graph->sizeVert / bottomUpToTopDown;
+        }
+        if(parallel) {
+            frontierEdges = bottomUp ? parallelBottomUpStep(level) : parallelTopDownStep(level);
+            gatherNextFrontier();
+        } else {
+            frontierEdges = bottomUp ? bottomUpStep(level) : topDownStep(level);
+        }
+        unexploredEdges -= frontierEdges;
+    }
+    
+    if(parallel) {
+        //blocks of whole 64-bit words of the vector <bool>, so threads never share one
+        const size_t blockSize = 4096;
+        pool->parallelFor((graph->sizeVert + blockSize - 1) / blockSize, [&](size_t block, size_t) {
+            size_t end = min(static_cast<size_t>(graph->sizeVert), (block + 1) * blockSize);
+            for(size_t vert = block * blockSize;vert < end; ++vert) {
+                (*used)[vert] = (*dist)[vert] != UNREACHED;
+            }
+        });
+    }
+    return (*used)[sink];
+}
+
+//after a run that reached the sink: unlabels (dist UNREACHED) every vertex with no shortest residual path to
+//the sink, found by a reverse search from the sink over the admissible arcs. used is left as it was
+void Bfs::pruneDeadEnds() {
+    vector <IndexType>& distRef = *dist;
+    const CapacityType* flow = &network->flow[0];
+    onShortestPath.assign(graph->sizeVert, false);
+    onShortestPath[sink] = true;
+    frontier.assign(1, sink);
+    while(!frontier.empty()) {
+        IndexType vert = frontier.back();
+        frontier.pop_back();
+        IndexType prevLevel = distRef[vert] - 1;
+        const IndexType* edgeIds = graph->incomingList.edgeIds.begin();
+        const IndexType* edgeIdsEnd = edgeIds + graph->incomingList.offsets[vert + 1];
+        for(edgeIds += graph->incomingList.offsets[vert];edgeIds != edgeIdsEnd;++edgeIds) {
+            IndexType prevVert = graph->edgeStart[*edgeIds];
+            if(!onShortestPath[prevVert] && distRef[prevVert] == prevLevel && graph->edgeCapacity[*edgeIds] - flow[*edgeIds] >= minResidual) {
+                onShortestPath[prevVert] = true;
+                frontier.push_back(prevVert);
+            }
+        }
+        edgeIds = graph->outgoingList.edgeIds.begin();
+        edgeIdsEnd = edgeIds + graph->outgoingList.offsets[vert + 1];
+        for(edgeIds += graph->outgoingList.offsets[vert];edgeIds != edgeIdsEnd;++edgeIds) {
+            IndexType prevVert = graph->edgeFinish[*edgeIds];
+            if(!onShortestPath[prevVert] && distRef[prevVert] == prevLevel && flow[*edgeIds] >= minResidual) {
+                onShortestPath[prevVert] = true;
+                frontier.push_back(prevVert);
+            }
+        }
+    }
+    for(size_t vert = 0;vert < graph->sizeVert; ++vert) {
+        if(!onShortestPath[vert]) {
+            distRef[vert] = UNREACHED;
+        }
+    }
+}
+
+ShortPathNetwork::ShortPathNetwork(Graph* graph, size_t source, size_t sink, vector <IndexType>& edgeID):
+Network(graph, source, sink), edgeID(edgeID){
+}
+
+ShortPathNetwork::~ShortPathNetwork() {
+    delete &edgeID;
+    //delete graph;
+}
+
+AccessLinkCutTree::AccessLinkCutTree(size_t sizeVert): _currentEpoch(0), rotationCount(0) {
+    nodes.resize(sizeVert);
+    for(size_t i = 0;i < nodes.size(); ++i) {
+        nodes[i].key = i;
+    }
+    _epoch.assign(sizeVert, 0);
+    clearTrees();
+    _pushPath.reserve(sizeVert);
+}
+
+//O(1) but once in 2^32 calls, when the epoch counter wraps and the stamps have to be rewritten
+void AccessLinkCutTree::clearTrees() {
+    if(++_currentEpoch == 0) {
+        std::fill(_epoch.begin(), _epoch.end(), 0);
+        _currentEpoch = 1;
+    }
+}
+
+size_t AccessLinkCutTree::memoryBytes() const {
+    return nodes.capacity() * sizeof(LinkCutNode) + _epoch.capacity() * sizeof(IndexType)
+           + _pushPath.capacity() * sizeof(IndexType);
+}
+
+inline void AccessLinkCutTree::_touch(IndexType vertex) {
+    if(_epoch[vertex] != _currentEpoch) {
+        _epoch[vertex] = _currentEpoch;
+        LinkCutNode& node = nodes[vertex];
+        node.leftChild = NO_NODE;
+        node.rightChild = NO_NODE;
+        node.parent = NO_NODE;
+        node.subtreeMinWeight = 0;
+        node.removedWeightValue = 0;
+        node.edgeWeight = 0;
+    }
+}
+
+inline size_t AccessLinkCutTree::_getMin(IndexType vertex) const {
+    if(vertex == NO_NODE) {
+        return INF;
+    }
+    return nodes[vertex].subtreeMinWeight - nodes[vertex].removedWeightValue;
+}
+
+inline bool AccessLinkCutTree::_isSplayRoot(IndexType vertex) const {
+    IndexType parent = nodes[vertex].parent;
+    return parent == NO_NODE || (nodes[parent].leftChild != vertex && nodes[parent].rightChild != vertex);
+}
+
+inline void AccessLinkCutTree::_update(IndexType vertex) {
+    LinkCutNode& node = nodes[vertex];
+    node.subtreeMinWeight = min(min(_getMin(node.leftChild), _getMin(node.rightChild)), nodes[vertex].edgeWeight);
+}
+
+inline void AccessLinkCutTree::_push(IndexType vertex) {
+    LinkCutNode& node = nodes[vertex];
+    size_t removed = node.removedWeightValue;
+    if(removed) {
+        nodes[vertex].edgeWeight -= removed;
+        node.subtreeMinWeight -= removed;
+        if(node.leftChild != NO_NODE) {
+            nodes[node.leftChild].removedWeightValue += removed;
+        }
+        if(node.rightChild != NO_NODE) {
+            nodes[node.rightChild].removedWeightValue += removed;
+        }
+        node.removedWeightValue = 0;
+    }
+}
+
+//lifts vertex over its parent, both already pushed. vertex takes over the subtree of parent and its minimum,
+//so only parent is updated
+void AccessLinkCutTree::_rotate(IndexType vertex) {
+    ++rotationCount;
+    LinkCutNode& node = nodes[vertex];
+    IndexType parent = node.parent;
+    LinkCutNode& parentNode = nodes[parent];
+    IndexType grandParent = parentNode.parent;
+    
+    if(!_isSplayRoot(parent)) {
+        if(nodes[grandParent].leftChild == parent) {
+            nodes[grandParent].leftChild = vertex;
+        } else {
+            nodes[grandParent].rightChild = vertex;
+        }
+    }
+    node.parent = grandParent;
+    
+    IndexType moved;
+    if(parentNode.leftChild == vertex) {
+        moved = node.rightChild;
+        parentNode.leftChild = moved;
+        node.rightChild = parent;
+    } else {
+        moved = node.leftChild;
+        parentNode.rightChild = moved;
+        node.leftChild = parent;
+    }
+    if(moved != NO_NODE) {
+        nodes[moved].parent = parent;
+    }
+    parentNode.parent = vertex;
+    
+    node.subtreeMinWeight = parentNode.subtreeMinWeight;
+    _update(parent);
+}
+
+//pushes the splay path top-down first, then rotates without recursion
+void AccessLinkCutTree::_splay(IndexType vertex) {
+    _pushPath.clear();
+    IndexType ancestor = vertex;
+    _pushPath.push_back(ancestor);
+    while(!_isSplayRoot(ancestor)) {
+        ancestor = nodes[ancestor].parent;
+        _pushPath.push_back(ancestor);
+    }
+    for(size_t i = _pushPath.size();i > 0; --i) {
+        _push(_pushPath[i - 1]);
+    }
+    
+    while(!_isSplayRoot(vertex)) {
+        IndexType parent = nodes[vertex].parent;
+        if(!_isSplayRoot(parent)) {
+            IndexType grandParent = nodes[parent].parent;
+            bool zigZigFlag = ((nodes[grandParent].leftChild == parent) == (nodes[parent].leftChild == vertex));
+            _rotate(zigZigFlag ? parent : vertex);
+        }
+        _rotate(vertex);
+    }
+}
+
+//makes the tree path from the root to vertex preferred and vertex the root of its splay tree, with no right child
+void AccessLinkCutTree::_access(IndexType vertex) {
+    IndexType last = NO_NODE;
+    for(IndexType pathTop = vertex;pathTop != NO_NODE; pathTop = nodes[pathTop].parent) {
+        _splay(pathTop);
+        nodes[pathTop].rightChild = last;
+        _update(pathTop);
+        last = pathTop;
+    }
+    _splay(vertex);
+}
+
+IndexType AccessLinkCutTree::_leftest(IndexType vertex) {
+    while(nodes[vertex].leftChild != NO_NODE) {
+        vertex = nodes[vertex].leftChild;
+    }
+    _splay(vertex);
+    return vertex;
+}
+
+void AccessLinkCutTree::link(size_t indRoot, size_t indVert) {
+    _touch(indRoot);
+    _touch(indVert);
+    _access(indRoot);
+    nodes[indRoot].parent = indVert;
+}
+
+//the parent is whatever precedes indVert on its path after _access, the parent argument of the LinkCutTree
+//interface is not needed
+void AccessLinkCutTree::cut(size_t indVert, size_t) {
+    _touch(indVert);
+    _access(indVert);
+    LinkCutNode& node = nodes[indVert];
+    if(node.leftChild != NO_NODE) {
+        nodes[node.leftChild].parent = NO_NODE;
+        node.leftChild = NO_NODE;
+        _update(indVert);
+    }
+}
+
+LinkCutNode* AccessLinkCutTree::findRoot(size_t ind) {
+    _touch(ind);
+    _access(ind);
+    return &nodes[_leftest(ind)];
+}
+
+LinkCutNode* AccessLinkCutTree::getMinEdge(size_t ind) {
+    IndexType vertex = ind;
+    _touch(vertex);
+    _access(vertex);
+    size_t minValue = _getMin(vertex);
+    while(true) {
+        _push(vertex);
+        if(_getMin(nodes[vertex].leftChild) == minValue) {
+            vertex = nodes[vertex].leftChild;
+        } else if(nodes[vertex].edgeWeight == minValue) {
+            break;
+        } else {
+            vertex = nodes[vertex].rightChild;
+        }
+    }
+    _splay(vertex);
+    return &nodes[vertex];
+}
+
+void AccessLinkCutTree::setWeight(size_t indVert, size_t weight) {
+    _touch(indVert);
+    _splay(indVert);
+    nodes[indVert].edgeWeight = weight;
+    _update(indVert);
+}
+
+void AccessLinkCutTree::removeWeightInPath(size_t added, size_t indVert) {
+    _touch(indVert);
+    _access(indVert);
+    nodes[indVert].removedWeightValue += added;
+}
+
+size_t AccessLinkCutTree::getEdgeWeight(size_t indVert) {
+    _touch(indVert);
+    _splay(indVert);
+    return nodes[indVert].edgeWeight;
+}
+
+//the vertex right below the root on the path from ind
+LinkCutNode* AccessLinkCutTree::prevInPath(size_t ind) {
+    _touch(ind);
+    _access(ind);
+    IndexType root = _leftest(ind);
+    if(nodes[root].rightChild == NO_NODE) {
+        return nullptr;
+    }
+    return &nodes[_leftest(nodes[root].rightChild)];
+}
+
+template <class DynamicTree>
+DynamicTreeBlockFlowFinder<DynamicTree>::DynamicTreeBlockFlowFinder(size_t sizeVert, size_t source, size_t sink): linkCut(sizeVert), source(source), sink(sink) {
+};
+
+template <class DynamicTree>
+DynamicTreeBlockFlowFinder<DynamicTree>::~DynamicTreeBlockFlowFinder() {
+    //delete &linkCut;
+}
+
+template <class DynamicTree>
+void DynamicTreeBlockFlowFinder<DynamicTree>::addEdge(size_t vertex, size_t nextVert, AdjacencyList& outEdges, Graph* graph) {
+    linkCut.setWeight(vertex, graph->edgeCapacity[outEdges.edgeIds[curEdgeNumber[vertex]]]);
+    linkCut.link(vertex, nextVert);
+    linkCut.findRoot(source);
+    linkCut.setWeight(linkCut.findRoot(source)->key, INF);
+    edgeInsideTreeFlag[vertex] = true;
+}
+
+template <class DynamicTree>
+void DynamicTreeBlockFlowFinder<DynamicTree>::removeEdge(size_t vertex, size_t prevVert, AdjacencyList& outEdges, Graph* graph) {
+    linkCut.cut(prevVert, vertex);
+    graph->writableCapacity()[outEdges.edgeIds[curEdgeNumber[prevVert]]] = linkCut.getEdgeWeight(prevVert);
+    linkCut.setWeight(prevVert, INF);
+    ++curEdgeNumber[prevVert];
+    edgeInsideTreeFlag[prevVert] = false;
+}
+
+template <class DynamicTree>
+void DynamicTreeBlockFlowFinder<DynamicTree>::decreaseWeightsInPath(size_t minWeight, AdjacencyList& outEdges, Graph* graph) {
+    size_t minVert;
+    linkCut.removeWeightInPath(minWeight, source);
+    while(linkCut.getEdgeWeight(minVert = linkCut.getMinEdge(source)->key) == 0) {
+        graph->writableCapacity()[outEdges.edgeIds[curEdgeNumber[minVert]]] = 0;
+        linkCut.cut(minVert, graph->edgeFinish[outEdges.edgeIds[curEdgeNumber[minVert]]]);
+        linkCut.setWeight(minVert, INF);
+        ++curEdgeNumber[minVert];
+        edgeInsideTreeFlag[minVert] = false;
+        if(minVert == source) {
+            break;
+        }
+    }
+}
+
+template <class DynamicTree>
+void DynamicTreeBlockFlowFinder<DynamicTree>::updateBlockFlow(vector <CapacityType>& flow, AdjacencyList& outEdges, Graph* graph) {
+    IndexType start;
+    for(size_t i = 0;i < flow.size(); ++i) {
+        start = graph->edgeStart[i];
+        if(curEdgeNumber[start] != outEdges.offsets[start + 1]
+           && outEdges.edgeIds[curEdgeNumber[start]] == i && edgeInsideTreeFlag[start]) {
+            (flow)[i] -= linkCut.getEdgeWeight(start);
+        } else {
+            (flow)[i] -= graph->edgeCapacity[i];
+        }
+    }
+
+}
+
+template <class DynamicTree>
+void DynamicTreeBlockFlowFinder<DynamicTree>::findBlockFlow() {
+    source = shortPathNetwork->source;
+    sink = shortPathNetwork->sink;
+    AdjacencyList& outEdges = shortPathNetwork->graph->outgoingList;
+    curEdgeNumber.assign(outEdges.offsets.begin(), outEdges.offsets.end() - 1);
+    edgeInsideTreeFlag.clear();
+    edgeInsideTreeFlag.resize(shortPathNetwork->graph->sizeVert, false);
+    Graph* graph = shortPathNetwork->graph;
+    vector <CapacityType>& flow = shortPathNetwork->flow;
+    
+    size_t vertex;
+    size_t nextVert;
+    size_t prevVert;
+    
+    for(size_t i = 0;i < graph->sizeEdge; ++i) {
+        flow[i] = graph->edgeCapacity[i];
+    }
+    
+    linkCut.clearTrees();
+    
+    while(true) {
+        if((vertex = linkCut.findRoot(source)->key) != sink) {
+            if(curEdgeNumber[vertex] != outEdges.offsets[vertex + 1]) {
+                nextVert = graph->edgeFinish[outEdges.edgeIds[curEdgeNumber[vertex]]];
+                
+                addEdge(vertex, nextVert, outEdges, graph);//Step 1
+            } else {
+                if(vertex == source) {
+                    edgeInsideTreeFlag[source] = false;//Step 2
+                    break;
+                } else {
+                    prevVert = linkCut.prevInPath(source)->key;
+                    
+                    removeEdge(vertex, prevVert, outEdges, graph);//Step 3
+                }
+            }
+        } else {
+            size_t minWeight = linkCut.getMinEdge(source)->edgeWeight;
+            
+            decreaseWeightsInPath(minWeight, outEdges, graph);//Step 4
+        }
+    }
+    
+    updateBlockFlow(flow, outEdges, graph);
+    
+    }
+
+template <class DynamicTree>
+void DynamicTreeBlockFlowFinder<DynamicTree>::addArc(size_t vertex, size_t nextVert, LevelGraph& levelGraph) {
+    linkCut.setWeight(vertex, levelGraph.arcResidual(curArc[vertex]));
+    linkCut.link(vertex, nextVert);
+    linkCut.setWeight(linkCut.findRoot(source)->key, INF);
+    edgeInsideTreeFlag[vertex] = true;
+}
+
+template <class DynamicTree>
+void DynamicTreeBlockFlowFinder<DynamicTree>::removeArc(size_t vertex, size_t prevVert, LevelGraph& levelGraph) {
+    linkCut.cut(prevVert, vertex);
+    levelGraph.pushFlow(curArc[prevVert], levelGraph.arcResidual(curArc[prevVert]) - linkCut.getEdgeWeight(prevVert));
+    linkCut.setWeight(prevVert, INF);
+    levelGraph.nextArc(prevVert, curArc[prevVert]);
+    edgeInsideTreeFlag[prevVert] = false;
+}
+
+template <class DynamicTree>
+void DynamicTreeBlockFlowFinder<DynamicTree>::decreaseWeightsInPath(size_t minWeight, LevelGraph& levelGraph) {
+    size_t minVert;
+    linkCut.removeWeightInPath(minWeight, source);
+    while(linkCut.getEdgeWeight(minVert = linkCut.getMinEdge(source)->key) == 0) {
+        levelGraph.pushFlow(curArc[minVert], levelGraph.arcResidual(curArc[minVert]));
+        linkCut.cut(minVert, levelGraph.arcHead(curArc[minVert]));
+        linkCut.setWeight(minVert, INF);
+        levelGraph.nextArc(minVert, curArc[minVert]);
+        edgeInsideTreeFlag[minVert] = false;
+        if(minVert == source) {
+            break;
+        }
+    }
+}
+
+//same steps as findBlockFlow(), arcs come from the view and flow of an arc is written when it leaves the tree
+template <class DynamicTree>
+void DynamicTreeBlockFlowFinder<DynamicTree>::findBlockFlow(LevelGraph& levelGraph) {
+    source = levelGraph.network->source;
+    sink = levelGraph.network->sink;
+    size_t sizeVert = levelGraph.graph->sizeVert;
+    curArc.resize(sizeVert);
+    for(size_t vert = 0;vert < sizeVert; ++vert) {
+        curArc[vert] = levelGraph.firstArc(vert);
+    }
+    edgeInsideTreeFlag.assign(sizeVert, false);
+    
+    size_t vertex;
+    size_t prevVert;
+    
+    linkCut.clearTrees();
+    
+    while(true) {
+        if((vertex = linkCut.findRoot(source)->key) != sink) {
+            if(levelGraph.findUsableArc(vertex, curArc[vertex])) {
+                addArc(vertex, levelGraph.arcHead(curArc[vertex]), levelGraph);//Step 1
+            } else {
+                if(vertex == source) {
+                    edgeInsideTreeFlag[source] = false;//Step 2
+                    break;
+                } else {
+                    prevVert = linkCut.prevInPath(source)->key;
+                    
+                    removeArc(vertex, prevVert, levelGraph);//Step 3
+                }
+            }
+        } else {
+            size_t minWeight = linkCut.getMinEdge(source)->edgeWeight;
+            
+            decreaseWeightsInPath(minWeight, levelGraph);//Step 4
+        }
+    }
+    
+    for(size_t vert = 0;vert < sizeVert; ++vert) {
+        if(edgeInsideTreeFlag[vert]) {
+            levelGraph.pushFlow(curArc[vert], levelGraph.arcResidual(curArc[vert]) - linkCut.getEdgeWeight(vert));
+        }
+    }
+}
+
+//on the copied network every edge goes one level up, flow of the network is the blocking flow itself
+void DfsBlockFlowFinder::findBlockFlow() {
+    size_t source = shortPathNetwork->source;
+    size_t sink = shortPathNetwork->sink;
+    Graph* graph = shortPathNetwork->graph;
+    AdjacencyList& outEdges = graph->outgoingList;
+    vector <CapacityType>& flow = shortPathNetwork->flow;
+    flow.assign(graph->sizeEdge, 0);
+    curArc.assign(outEdges.offsets.begin(), outEdges.offsets.end() - 1);
+    path.clear();
+    
+    size_t vert = source;
+    while(true) {
+        if(vert == sink) {
+            CapacityType bottleneck = graph->edgeCapacity[path[0]] - flow[path[0]];
+            size_t firstSaturated = 0;
+            for(size_t i = 1;i < path.size(); ++i) {
+                if(graph->edgeCapacity[path[i]] - flow[path[i]] < bottleneck) {
+                    bottleneck = graph->edgeCapacity[path[i]] - flow[path[i]];
+                    firstSaturated = i;
+                }
+            }
+            for(size_t i = 0;i < path.size(); ++i) {
+                flow[path[i]] += bottleneck;
+            }
+            path.resize(firstSaturated);
+            vert = path.empty() ? source : graph->edgeFinish[path.back()];
+            continue;
+        }
+        size_t end = outEdges.offsets[vert + 1];
+        while(curArc[vert] != end && flow[outEdges.edgeIds[curArc[vert]]] == graph->edgeCapacity[outEdges.edgeIds[curArc[vert]]]) {
+            ++curArc[vert];
+        }
+        if(curArc[vert] != end) {
+            IndexType edge = outEdges.edgeIds[curArc[vert]];
+            path.push_back(edge);
+            vert = graph->edgeFinish[edge];
+        } else if(vert == source) {
+            break;
+        } else {
+            path.pop_back();
+            vert = path.empty() ? source : graph->edgeFinish[path.back()];
+            ++curArc[vert];
+        }
+    }
+}
+
+void DfsBlockFlowFinder::findBlockFlow(LevelGraph& levelGraph) {
+    size_t source = levelGraph.network->source;
+    size_t sink = levelGraph.network->sink;
+    size_t sizeVert = levelGraph.graph->sizeVert;
+    curArc.resize(sizeVert);
+    for(size_t vert = 0;vert < sizeVert; ++vert) {
+        curArc[vert] = levelGraph.firstArc(vert);
+    }
+    path.clear();
+    
+    size_t vert = source;
+    while(true) {
+        if(vert == sink) {
+            CapacityType bottleneck = levelGraph.arcResidual(path[0]);
+            size_t firstSaturated = 0;
+            for(size_t i = 1;i < path.size(); ++i) {
+                CapacityType residual = levelGraph.arcResidual(path[i]);
+                if(residual < bottleneck) {
+                    bottleneck = residual;
+                    firstSaturated = i;
+                }
+            }
+            for(size_t i = 0;i < path.size(); ++i) {
+                levelGraph.pushFlow(path[i], bottleneck);
+            }
+            path.resize(firstSaturated);
+            vert = path.empty() ? source : levelGraph.arcHead(path.back());
+            continue;
+        }
+        if(levelGraph.findUsableArc(vert, curArc[vert])) {
+            path.push_back(curArc[vert]);
+            vert = levelGraph.arcHead(curArc[vert]);
+        } else if(vert == source) {
+            break;
+        } else {
+            path.pop_back();
+            vert = path.empty() ? source : levelGraph.arcHead(path.back());
+            levelGraph.nextArc(vert, curArc[vert]);
+        }
+    }
+}
+
+//**********************************************************************************************
+
+ThreadPool::ThreadPool(size_t threadCount): _job(nullptr), _generation(0), _pending(0), _stop(false) {
+    for(size_t i = 1;i < threadCount; ++i) {
+        _workers.push_back(std::thread(&ThreadPool::_workerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wakeUp.notify_all();
+    for(size_t i = 0;i < _workers.size(); ++i) {
+        _workers[i].join();
+    }
+}
+
+void ThreadPool::_workerLoop(size_t threadIndex) {
+    size_t seenGeneration = 0;
+    while(true) {
+        const std::function<void(size_t)>* job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while(!_stop && _generation == seenGeneration) {
+                _wakeUp.wait(lock);
+            }
+            if(_stop) {
+                return;
+            }
+            seenGeneration = _generation;
+            job = _job;
+        }
+        (*job)(threadIndex);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if(--_pending == 0) {
+                _finished.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::run(const std::function<void(size_t)>& job) {
+    if(_workers.empty()) {
+        job(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _job = &job;
+        _pending = _workers.size();
+        ++_generation;
+    }
+    _wakeUp.notify_all();
+    job(0);
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(_pending != 0) {
+        _finished.wait(lock);
+    }
+}
+
+void ThreadPool::parallelFor(size_t taskCount, const std::function<void(size_t, size_t)>& body) {
+    if(taskCount <= 1 || _workers.empty()) {
+        //not worth waking the workers
+        for(size_t task = 0;task < taskCount; ++task) {
+            body(task, 0);
+        }
+        return;
+    }
+    std::atomic<size_t> nextTask(0);
+    run([&](size_t threadIndex) {
+        size_t task;
+        while((task = nextTask.fetch_add(1)) < taskCount) {
+            body(task, threadIndex);
+        }
+    });
+}
+
+MappedFile::MappedFile(): _data(nullptr), _size(0), _mapped(false) {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const char* path) {
+    close();
+#ifndef _WIN32
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+    struct stat fileInfo;
+    if(fstat(fd, &fileInfo) == 0 && fileInfo.st_size > 0) {
+        //read-only mapping: the pages are the page cache's own, a stray store faults instead of copying them
+        void* mapped = mmap(nullptr, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapped != MAP_FAILED) {
+            madvise(mapped, fileInfo.st_size, MADV_SEQUENTIAL);
+            _data = static_cast<char*>(mapped);
+            _size = fileInfo.st_size;
+            _mapped = true;
+            ::close(fd);
+            return true;
+        }
+    }
+    ::close(fd);
+#endif
+    FILE* file = fopen(path, "rb");
+    if(!file) {
+        return false;
+    }
+    char chunk[1 << 16];
+    size_t readBytes;
+    while((readBytes = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        _buffer.insert(_buffer.end(), chunk, chunk + readBytes);
+    }
+    fclose(file);
+    _data = _buffer.empty() ? nullptr : &_buffer[0];
+    _size = _buffer.size();
+    return true;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if(_mapped) {
+        munmap(_data, _size);
+    }
+#endif
+    _buffer.clear();
+    _data = nullptr;
+    _size = 0;
+    _mapped = false;
+}
+
+EdgeListParser::EdgeListParser(const char* begin, const char* end, GraphFormat format): _begin(begin), _pos(begin), _end(end),
+_format(format), error(nullptr), source(0), sink(0) {
+}
+
+inline void EdgeListParser::_skipLine() {
+    while(_pos != _end && *_pos != '\n') {
+        ++_pos;
+    }
+}
+
+inline void EdgeListParser::_skipBlank() {
+    while(true) {
+        while(_pos != _end && static_cast<unsigned char>(*_pos) <= ' ') {
+            ++_pos;
+        }
+        if(_format != FORMAT_DIMACS || _pos == _end || *_pos != 'c') {
+            return;
+        }
+        _skipLine();
+    }
+}
+
+inline void EdgeListParser::_skipSpaces() {
+    while(_pos != _end && *_pos != '\n' && static_cast<unsigned char>(*_pos) <= ' ') {
+        ++_pos;
+    }
+}
+
+inline bool EdgeListParser::_readNumberInLine(size_t& value) {
+    _skipSpaces();
+    return _pos != _end && *_pos != '\n' && _readNumber(value);
+}
+
+inline bool EdgeListParser::_readNumber(size_t& value) {
+    while(_pos != _end && static_cast<unsigned char>(*_pos) <= ' ') {
+        ++_pos;
+    }
+    if(_pos == _end || static_cast<unsigned char>(*_pos - '0') > 9) {
+        return false;
+    }
+    value = 0;
+    do {
+        size_t digit = *_pos - '0';
+        if(value > (static_cast<size_t>(-1) - digit) / 10) {
+            error = "number too large";
+            return false;
+        }
+        value = value * 10 + digit;
+        ++_pos;
+    } while(_pos != _end && static_cast<unsigned char>(*_pos - '0') <= 9);
+    return true;
+}
+
+//an edge fills exactly one line, as countEdgeLines assumes, so parse and parseParallel accept the same input
+inline bool EdgeListParser::_readEdge(size_t sizeVert, EdgeColumns& edges, size_t index) {
+    size_t start, finish, capacity;
+    _skipBlank();
+    if(_format == FORMAT_DIMACS) {
+        if(_pos == _end || *_pos != 'a') {
+            error = "expected \"a start finish capacity\" line";
+            return false;
+        }
+        ++_pos;
+    }
+    if(!_readNumberInLine(start) || !_readNumberInLine(finish) || !_readNumberInLine(capacity)) {
+        error = error ? error : "expected \"start finish capacity\" line";
+        return false;
+    }
+    _skipSpaces();
+    if(_pos != _end && *_pos != '\n') {
+        error = "more than one edge on a line";
+        return false;
+    }
+    if(start - 1 >= sizeVert || finish - 1 >= sizeVert) {
+        error = "vertex index out of range";
+        return false;
+    }
+    if(capacity > static_cast<CapacityType>(-1)) {
+        error = "capacity too large, rebuild with -DGRAPH_CAPACITY_64";
+        return false;
+    }
+    edges.start[index] = start - 1;
+    edges.finish[index] = finish - 1;
+    edges.capacity[index] = capacity;
+    return true;
+}
+
+//reads edgeCount edges into place, the rest of the input must be blank
+bool EdgeListParser::_readEdges(size_t sizeVert, EdgeColumns& edges, size_t first, size_t edgeCount) {
+    for(size_t i = first;i < first + edgeCount; ++i) {
+        if(!_readEdge(sizeVert, edges, i)) {
+            return false;
+        }
+    }
+    _skipBlank();
+    if(_pos != _end) {
+        error = "more than one edge on a line";
+        return false;
+    }
+    return true;
+}
+
+bool EdgeListParser::readPair(size_t& first, size_t& second) {
+    _skipBlank();
+    if(_pos == _end) {
+        return false;
+    }
+    if(!_readNumber(first) || !_readNumber(second)) {
+        error = error ? error : "expected a pair of numbers";
+        return false;
+    }
+    return true;
+}
+
+//lines holding an edge: every non-blank line of the native format, "a" lines of DIMACS
+size_t EdgeListParser::countEdgeLines(const char* begin, const char* end, GraphFormat format) {
+    size_t lines = 0;
+    bool lineStarted = false;
+    for(const char* pos = begin;pos != end; ++pos) {
+        if(*pos == '\n') {
+            lineStarted = false;
+        } else if(!lineStarted && static_cast<unsigned char>(*pos) > ' ') {
+            lineStarted = true;
+            lines += (format != FORMAT_DIMACS || *pos == 'a');
+        }
+    }
+    return lines;
+}
+
+bool EdgeListParser::parseHeader(size_t& sizeVert, size_t& sizeEdge) {
+    if(!(_format == FORMAT_DIMACS ? _parseDimacsHeader(sizeVert, sizeEdge) : _parseNativeHeader(sizeVert, sizeEdge))) {
+        return false;
+    }
+    //offsets go up to sizeEdge and UNREACHED must stay distinct from every vertex
+    if(sizeVert >= static_cast<IndexType>(-1) || sizeEdge >= static_cast<IndexType>(-1)) {
+        error = "graph too large for 32-bit indices, rebuild with -DGRAPH_INDEX_64";
+        return false;
+    }
+    return true;
+}
+
+bool EdgeListParser::_parseNativeHeader(size_t& sizeVert, size_t& sizeEdge) {
+    if(!_readNumber(sizeVert) || !_readNumber(sizeEdge)) {
+        error = error ? error : "expected \"V E\" header";
+        return false;
+    }
+    source = 0;
+    sink = sizeVert ? sizeVert - 1 : 0;
+    return true;
+}
+
+//reads the "p" and "n" lines, stops in front of the first "a" line
+bool EdgeListParser::_parseDimacsHeader(size_t& sizeVert, size_t& sizeEdge) {
+    bool problemSeen = false;
+    bool sourceSeen = false;
+    bool sinkSeen = false;
+    size_t vertex;
+    
+    _skipBlank();
+    while(_pos != _end && *_pos != 'a') {
+        if(*_pos == 'p') {
+            ++_pos;
+            _skipBlank();
+            if(_end - _pos < 3 || !equal(_pos, _pos + 3, "max")) {
+                error = "expected \"p max V E\"";
+                return false;
+            }
+            _pos += 3;
+            if(!_readNumber(sizeVert) || !_readNumber(sizeEdge)) {
+                error = error ? error : "expected \"p max V E\"";
+                return false;
+            }
+            problemSeen = true;
+        } else if(*_pos == 'n' && problemSeen) {
+            ++_pos;
+            if(!_readNumber(vertex) || vertex - 1 >= sizeVert) {
+                error = error ? error : "expected \"n vertex s|t\" with a vertex in range";
+                return false;
+            }
+            _skipBlank();
+            if(_pos != _end && *_pos == 's') {
+                source = vertex - 1;
+                sourceSeen = true;
+            } else if(_pos != _end && *_pos == 't') {
+                sink = vertex - 1;
+                sinkSeen = true;
+            } else {
+                error = "expected \"n vertex s|t\"";
+                return false;
+            }
+        } else {
+            error = problemSeen ? "unexpected line in DIMACS header" : "expected \"p max V E\" first";
+            return false;
+        }
+        _skipLine();
+        _skipBlank();
+    }
+    
+    if(!problemSeen || !sourceSeen || !sinkSeen) {
+        error = "DIMACS input needs a \"p max\" line and both \"n\" lines";
+        return false;
+    }
+    return true;
+}
+
+bool EdgeListParser::parse(size_t& sizeVert, EdgeColumns& edges) {
+    size_t sizeEdge;
+    if(!parseHeader(sizeVert, sizeEdge)) {
+        return false;
+    }
+    
+    edges.resize(sizeEdge);
+    for(size_t i = 0;i < sizeEdge; ++i) {
+        if(!_readEdge(sizeVert, edges, i)) {
+            return false;
+        }
+    }
+    //same rule as parseParallel: nothing but blanks and comments after the declared edges
+    _skipBlank();
+    if(_pos != _end) {
+        error = "number of edge lines differs from the header";
+        return false;
+    }
+    return true;
+}
+
+//splits the body at newline boundaries and parses the chunks in parallel, each straight into its place
+bool EdgeListParser::parseParallel(ThreadPool& pool, size_t& sizeVert, EdgeColumns& edges) {
+    size_t sizeEdge;
+    if(!parseHeader(sizeVert, sizeEdge)) {
+        return false;
+    }
+    
+    const size_t minChunkBytes = 1 << 20;
+    size_t chunkCount = min(pool.size() * 4, static_cast<size_t>(_end - _pos) / minChunkBytes + 1);
+    vector <const char*> bounds(chunkCount + 1, _end);
+    bounds[0] = _pos;
+    for(size_t i = 1;i < chunkCount; ++i) {
+        const char* bound = max(bounds[i - 1], _pos + (_end - _pos) / chunkCount * i);
+        while(bound != _end && *bound != '\n') {
+            ++bound;
+        }
+        bounds[i] = bound;
+    }
+    
+    //count lines first so every chunk parses straight into its final place, no second copy of the edges
+    vector <size_t> chunkStart(chunkCount + 1, 0);
+    pool.parallelFor(chunkCount, [&](size_t chunk, size_t) {
+        chunkStart[chunk + 1] = countEdgeLines(bounds[chunk], bounds[chunk + 1], _format);
+    });
+    for(size_t i = 0;i < chunkCount; ++i) {
+        chunkStart[i + 1] += chunkStart[i];
+    }
+    if(chunkStart[chunkCount] != sizeEdge) {
+        error = "number of edge lines differs from the header";
+        _pos = _end;
+        return false;
+    }
+    
+    edges.resize(sizeEdge);
+    vector <EdgeListParser> chunkParsers;
+    vector <char> chunkFailed(chunkCount, false);
+    for(size_t i = 0;i < chunkCount; ++i) {
+        chunkParsers.push_back(EdgeListParser(bounds[i], bounds[i + 1], _format));
+    }
+    size_t sizeVertCopy = sizeVert;
+    pool.parallelFor(chunkCount, [&](size_t chunk, size_t) {
+        size_t edgeCount = chunkStart[chunk + 1] - chunkStart[chunk];
+        chunkFailed[chunk] = !chunkParsers[chunk]._readEdges(sizeVertCopy, edges, chunkStart[chunk], edgeCount);
+    });
+    
+    for(size_t i = 0;i < chunkCount; ++i) {
+        if(chunkFailed[i]) {
+            error = chunkParsers[i].error;
+            _pos = chunkParsers[i]._pos;
+            return false;
+        }
+    }
+    _pos = _end;
+    return true;
+}
+
+//**********************************************************************************************
+
+//command line of the solver, see printUsage
+enum FlowAlgorithm {
+    ALGORITHM_DINIC,
+    ALGORITHM_SCALING_DINIC,
+    ALGORITHM_PUSH_RELABEL,
+    ALGORITHM_PARALLEL_PUSH_RELABEL,
+    ALGORITHM_BOYKOV_KOLMOGOROV,
+    ALGORITHM_PSEUDOFLOW
+};
+
+enum BlockFlowAlgorithm {
+    BLOCK_FLOW_LINK_CUT,
+    BLOCK_FLOW_LINK_CUT_SPLIT,
+    BLOCK_FLOW_DFS
+};
+
+struct Options {
+    const char* inputPath;
+    GraphFormat format;
+    size_t source;    //1-based as in the input files, 0 means the one declared by the input
+    size_t sink;
+    const char* queryPath;
+    size_t threadCount;
+    const char* flowPath;
+    bool binaryFlow;
+    const char* dimacsFlowPath;
+    const char* minCutPath;
+    const char* binaryPath;
+    const char* benchmark;
+    bool levelGraphView;
+    BfsMode bfsMode;
+    bool pruneLevelGraph;
+    bool detectUnitCapacity;  //default Dinic runs as UnitCapacityFlowFinder when all capacities are equal
+    FlowAlgorithm algorithm;
+    BlockFlowAlgorithm blockFlow;
+    
+    Options();
+    bool parse(int argc, char** argv);
+};
+
+void printUsage(const char* program);
+BlockFlowFinder* createBlockFlowFinder(const Options& options, size_t sizeVert);
+FlowFinder* createFlowFinder(const Options& options, BlockFlowFinder* blockFlowFinder, ThreadPool& pool, Graph* graph);
+int solveDinicMaxFlow(Options& options);
+int solveQueries(Options& options, Graph* graph, ThreadPool& pool);
+int convertToBinaryGraph(Options& options);
+int runBenchmark(const string& name, const char* path, size_t threadCount);
+void linkCutTest();
+
+int main(int argc, char** argv) {
+    ios_base::sync_with_stdio(false);
+    //freopen("output.txt", "w", stdout);
+    Options options;
+    if(!options.parse(argc, argv)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if(options.binaryPath) {
+        return convertToBinaryGraph(options);
+    }
+    if(options.benchmark) {
+        return runBenchmark(options.benchmark, options.inputPath, options.threadCount);
+    }
+    //while(1) {
+    return solveDinicMaxFlow(options);
+    //}
+}
+
+Options::Options(): inputPath("input.txt"), format(FORMAT_AUTO), source(0), sink(0), queryPath(nullptr), threadCount(1),
+flowPath(nullptr), binaryFlow(false), dimacsFlowPath(nullptr), minCutPath(nullptr), binaryPath(nullptr), benchmark(nullptr),
+levelGraphView(true), bfsMode(BFS_HYBRID), pruneLevelGraph(true), detectUnitCapacity(true),
+algorithm(ALGORITHM_DINIC), blockFlow(BLOCK_FLOW_LINK_CUT) {
+}
+
+//a 1-based vertex number that is the whole argument, so a typo can't fall back to the declared terminal
+bool parseVertexNumber(const char* text, size_t& vertex) {
+    vertex = 0;
+    for(const char* pos = text;*pos; ++pos) {
+        size_t digit = static_cast<unsigned char>(*pos - '0');
+        if(digit > 9 || vertex > (static_cast<size_t>(-1) - digit) / 10) {
+            return false;
+        }
+        vertex = vertex * 10 + digit;
+    }
+    return vertex != 0;
+}
+
+bool Options::parse(int argc, char** argv) {
+    for(int i = 1;i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "--input" && hasValue) {
+            inputPath = argv[++i];
+        } else if(arg == "--format" && hasValue) {
+            string name = argv[++i];
+            if(name == "auto") {
+                format = FORMAT_AUTO;
+            } else if(name == "native" || name == "text") {
+                format = FORMAT_NATIVE;
+            } else if(name == "dimacs") {
+                format = FORMAT_DIMACS;
+            } else if(name == "binary") {
+                format = FORMAT_BINARY;
+            } else {
+                cerr << "unknown format " << name << endl;
+                return false;
+            }
+        } else if((arg == "--source" || arg == "--sink") && hasValue) {
+            if(!parseVertexNumber(argv[++i], arg == "--source" ? source : sink)) {
+                cerr << arg << " takes a vertex number 1..V, not \"" << argv[i] << "\"" << endl;
+                return false;
+            }
+        } else if(arg == "--queries" && hasValue) {
+            queryPath = argv[++i];
+        } else if(arg == "--threads" && hasValue) {
+            threadCount = max(1, atoi(argv[++i]));
+        } else if(arg == "--flow-out" && hasValue) {
+            flowPath = argv[++i];
+        } else if(arg == "--flow-format" && hasValue) {
+            binaryFlow = string(argv[++i]) == "binary";
+        } else if(arg == "--dimacs-out" && hasValue) {
+            dimacsFlowPath = argv[++i];
+        } else if(arg == "--min-cut" && hasValue) {
+            minCutPath = argv[++i];
+        } else if(arg == "--convert" && i + 2 < argc) {
+            inputPath = argv[++i];
+            binaryPath = argv[++i];
+        } else if(arg == "--level-graph" && hasValue) {
+            string mode = argv[++i];
+            if(mode != "view" && mode != "copy") {
+                cerr << "unknown level graph mode " << mode << endl;
+                return false;
+            }
+            levelGraphView = mode == "view";
+        } else if(arg == "--bfs" && hasValue) {
+            string mode = argv[++i];
+            if(mode == "top-down") {
+                bfsMode = BFS_TOP_DOWN;
+            } else if(mode == "hybrid") {
+                bfsMode = BFS_HYBRID;
+            } else if(mode == "parallel") {
+                bfsMode = BFS_PARALLEL;
+            } else {
+                cerr << "unknown bfs mode " << mode << endl;
+                return false;
+            }
+        } else if(arg == "--prune" && hasValue) {
+            string mode = argv[++i];
+            if(mode != "on" && mode != "off") {
+                cerr << "--prune takes on or off" << endl;
+                return false;
+            }
+            pruneLevelGraph = mode == "on";
+        } else if(arg == "--unit-capacity" && hasValue) {
+            string mode = argv[++i];
+            if(mode != "auto" && mode != "off") {
+                cerr << "--unit-capacity takes auto or off" << endl;
+                return false;
+            }
+            detectUnitCapacity = mode == "auto";
+        } else if(arg == "--algorithm" && hasValue) {
+            string name = argv[++i];
+            if(name == "dinic") {
+                algorithm = ALGORITHM_DINIC;
+            } else if(name == "scaling-dinic") {
+                algorithm = ALGORITHM_SCALING_DINIC;
+            } else if(name == "push-relabel") {
+                algorithm = ALGORITHM_PUSH_RELABEL;
+            } else if(name == "parallel-push-relabel") {
+                algorithm = ALGORITHM_PARALLEL_PUSH_RELABEL;
+            } else if(name == "boykov-kolmogorov") {
+                algorithm = ALGORITHM_BOYKOV_KOLMOGOROV;
+            } else if(name == "pseudoflow") {
+                algorithm = ALGORITHM_PSEUDOFLOW;
+            } else {
+                cerr << "unknown algorithm " << name << endl;
+                return false;
+            }
+        } else if(arg == "--block-flow" && hasValue) {
+            string name = argv[++i];
+            if(name == "link-cut") {
+                blockFlow = BLOCK_FLOW_LINK_CUT;
+            } else if(name == "link-cut-split") {
+                blockFlow = BLOCK_FLOW_LINK_CUT_SPLIT;
+            } else if(name == "dfs") {
+                blockFlow = BLOCK_FLOW_DFS;
+            } else {
+                cerr << "unknown blocking flow finder " << name << endl;
+                return false;
+            }
+        } else if(arg == "--bench" && hasValue) {
+            benchmark = argv[++i];
+        } else if(arg[0] != '-') {
+            inputPath = argv[i];
+        } else {
+            cerr << "unknown option " << arg << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void printUsage(const char* program) {
+    cerr << "usage: " << program << " [options] [graph file, input.txt by default]\n"
+            "  --input PATH          graph file\n"
+            "  --format F            auto (default), native, dimacs or binary\n"
+            "  --source ID --sink ID 1-based terminals, default: declared by the input (1 and V for native)\n"
+            "  --queries PATH        file of \"source sink\" lines, all solved on the loaded graph\n"
+            "  --threads N           threads for parsing, output, the parallel bfs and parallel-push-relabel\n"
+            "  --flow-out PATH       per-edge flow, --flow-format text (default) or binary\n"
+            "  --dimacs-out PATH     DIMACS flow solution\n"
+            "  --min-cut PATH        source side and cut edges\n"
+            "  --algorithm A         dinic (default), scaling-dinic (Dinic with capacity scaling), push-relabel\n"
+            "                        parallel-push-relabel (push-relabel on --threads threads), boykov-kolmogorov\n"
+            "                        or pseudoflow (lowest label)\n"
+            "  --block-flow B        blocking flows of Dinic: link-cut (default, link-cut trees on access), link-cut-split\n"
+            "                        (link-cut trees on splay tree split and merge) or dfs (current-arc dfs)\n"
+            "  --level-graph M       Dinic phases on a view of the graph (view, default) or on a copied network (copy)\n"
+            "  --bfs M               level bfs: hybrid (default, top-down and bottom-up steps), top-down,\n"
+            "                        or parallel (hybrid on --threads threads)\n"
+            "  --prune on|off        drop level graph vertices off shortest paths to the sink (default on)\n"
+            "  --unit-capacity M     auto (default): Dinic with default settings on a graph whose capacities are all\n"
+            "                        equal runs the bitset unit capacity engine, off: never\n"
+            "  --convert IN OUT      write IN as a binary graph file\n"
+            "  --bench NAME          run a benchmark, see the end of FINAL_CODE.cpp" << endl;
+}
+
+BlockFlowFinder* createBlockFlowFinder(const Options& options, size_t sizeVert) {
+    if(options.blockFlow == BLOCK_FLOW_DFS) {
+        return new DfsBlockFlowFinder();
+    }
+    if(options.blockFlow == BLOCK_FLOW_LINK_CUT_SPLIT) {
+        return new SplitLinkCutBlockFlowFinder(sizeVert, 0, 0);
+    }
+    return new LinkCutBlockFlowFinder(sizeVert, 0, 0);
+}
+
+FlowFinder* createFlowFinder(const Options& options, BlockFlowFinder* blockFlowFinder, ThreadPool& pool, Graph* graph) {
+    if(options.algorithm == ALGORITHM_PUSH_RELABEL) {
+        return new PushRelabelFlowFinder();
+    }
+    if(options.algorithm == ALGORITHM_PARALLEL_PUSH_RELABEL) {
+        return new ParallelPushRelabelFlowFinder(&pool);
+    }
+    if(options.algorithm == ALGORITHM_BOYKOV_KOLMOGOROV) {
+        return new BoykovKolmogorovFlowFinder();
+    }
+    if(options.algorithm == ALGORITHM_PSEUDOFLOW) {
+        return new PseudoflowFlowFinder();
+    }
+    //only plain Dinic as configured by default is swapped, an explicitly chosen variant, blocking flow,
+    //level graph, bfs or pruning mode is run as asked
+    Options defaults;
+    bool defaultDinic = options.algorithm == ALGORITHM_DINIC && options.blockFlow == defaults.blockFlow
+                     && options.levelGraphView == defaults.levelGraphView && options.bfsMode == defaults.bfsMode
+                     && options.pruneLevelGraph == defaults.pruneLevelGraph;
+    if(options.detectUnitCapacity && defaultDinic && uniformCapacity(graph) != 0) {
+        cerr << "all capacities are equal, running the unit capacity engine (--unit-capacity off keeps Dinic)" << endl;
+        return new UnitCapacityFlowFinder();
+    }
+    DinicFlowFinder* dinicFlowFinder;
+    if(options.algorithm == ALGORITHM_SCALING_DINIC) {
+        dinicFlowFinder = new ScalingDinicFlowFinder(blockFlowFinder, options.levelGraphView);
+    } else {
+        dinicFlowFinder = new DinicFlowFinder(blockFlowFinder, options.levelGraphView);
+    }
+    dinicFlowFinder->bfs.mode = options.bfsMode;
+    dinicFlowFinder->bfs.pool = &pool;
+    dinicFlowFinder->pruneLevelGraph = options.pruneLevelGraph;
+    return dinicFlowFinder;
+}
+
+int convertToBinaryGraph(Options& options) {
+    ThreadPool pool(options.threadCount);
+    Graph* graph = loadGraphFile(options.inputPath, nullptr, &pool, options.format);
+    if(!graph) {
+        return 1;
+    }
+    bool written = writeBinaryGraph(options.binaryPath, *graph);
+    if(!written) {
+        cerr << "can't write " << options.binaryPath << endl;
+    }
+    delete graph;
+    return written ? 0 : 1;
+}
+
+int solveDinicMaxFlow(Options& options) {
+    LoadStats loadStats;
+    ThreadPool pool(options.threadCount);
+    Graph* graph = loadGraphFile(options.inputPath, &loadStats, &pool, options.format);
+    if(!graph) {
+        return 1;
+    }
+    cerr << "loaded " << loadStats.bytes << " bytes in " << loadStats.seconds * 1000 << " ms ("
+         << loadStats.megabytesPerSecond() << " MB/s, " << loadStats.threads << " threads), peak memory "
+         << peakMemoryKilobytes() / 1024 << " MB, graph " << graph->memoryBytes() / 1024 << " KB with "
+         << sizeof(IndexType) * 8 << "-bit indices and " << sizeof(CapacityType) * 8 << "-bit capacities" << endl;
     
-    calcMaxFlow();
+    if(options.queryPath) {
+        return solveQueries(options, graph, pool);
+    }
     
-    return;
+    size_t vert = graph->sizeVert;
+    size_t source = options.source ? options.source - 1 : graph->declaredSource;
+    size_t sink = options.sink ? options.sink - 1 : graph->declaredSink;
+    if(source >= vert || sink >= vert || source == sink) {
+        cerr << "source and sink must be different vertices in 1.." << vert << endl;
+        delete graph;
+        return 1;
+    }
+    BlockFlowFinder* blockFlowFinder = createBlockFlowFinder(options, vert);
+    FlowFinder* flowFinder = createFlowFinder(options, blockFlowFinder, pool, graph);
+    Network network(graph, source, sink);
+    network.getMaxFlow(*flowFinder);
+    cout << network.maxFlow << endl;
+    
+    if(options.minCutPath) {
+        MinCut cut;
+        flowFinder->getMinCut(cut);
+        if(!writeMinCut(options.minCutPath, network, cut)) {
+            cerr << "can't write " << options.minCutPath << endl;
+        }
+    }
+    if(options.dimacsFlowPath && !writeDimacsFlow(options.dimacsFlowPath, network, &pool)) {
+        cerr << "can't write " << options.dimacsFlowPath << endl;
+    }
+    if(options.flowPath) {
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        if(!(options.binaryFlow ? writeFlowBinary(options.flowPath, network) : writeFlowText(options.flowPath, network, &pool))) {
+            cerr << "can't write " << options.flowPath << endl;
+        }
+        cerr << "flow of " << network.flow.size() << " edges written in "
+             << std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() * 1000 << " ms" << endl;
+    }
+    delete flowFinder;
+    delete blockFlowFinder;
+    return 0;
 }
 
-bool DinicFlowFinder::getShortPathNetwork() {
-    vector <DirectEdge> shortPathEdges;// = new vector <DirectEdge>;
-    vector <size_t>* edgeID = new vector <size_t>;
+//one graph, one network and one finder for all queries; every query only resets their state.
+//prints "source sink maxflow" per query line
+int solveQueries(Options& options, Graph* graph, ThreadPool& pool) {
+    MappedFile queries;
+    if(!queries.open(options.queryPath)) {
+        cerr << "can't open " << options.queryPath << endl;
+        delete graph;
+        return 1;
+    }
     
-    bfs.init(network);
+    size_t vert = graph->sizeVert;
+    BlockFlowFinder* blockFlowFinder = createBlockFlowFinder(options, vert);
+    FlowFinder* flowFinder = createFlowFinder(options, blockFlowFinder, pool, graph);
+    Network network(graph, 0, 0);
     
-    if(!bfs.run()) {
-        return false;
+    EdgeListParser parser(queries.data(), queries.data() + queries.size(), FORMAT_NATIVE);
+    BulkWriter writer(stdout);
+    size_t source, sink;
+    size_t queryCount = 0;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    while(parser.readPair(source, sink)) {
+        if(source - 1 >= vert || sink - 1 >= vert || source == sink) {
+            cerr << options.queryPath << ": query " << source << " " << sink << " is not a pair of different vertices in 1.." << vert << endl;
+            delete flowFinder;
+            delete blockFlowFinder;
+            return 1;
+        }
+        network.reset(source - 1, sink - 1);
+        network.getMaxFlow(*flowFinder);
+        
+        writer.writeNumber(source);
+        writer.writeChar(' ');
+        writer.writeNumber(sink);
+        writer.writeChar(' ');
+        writer.writeNumber(network.maxFlow);
+        writer.writeChar('\n');
+        ++queryCount;
     }
-    
-    DirectEdge curEdge;
-    vector <DirectEdge>& edgeList = network->graph->edgeList;
-    for(size_t i = 0;i < edgeList.size(); ++i) {
-        curEdge = edgeList[i];
-        if(checkEdgeForShortPath(i, curEdge)) {
-            edgeID->push_back(i);
-            shortPathEdges.push_back(curEdge);
+    if(parser.error) {
+        cerr << options.queryPath << ": " << parser.error << " at byte " << parser.errorOffset() << endl;
+        delete flowFinder;
+        delete blockFlowFinder;
+        return 1;
+    }
+    writer.flush();
+    fflush(stdout);
+    cerr << queryCount << " queries in " << secondsSince(startTime) * 1000 << " ms" << endl;
+    delete flowFinder;
+    delete blockFlowFinder;
+    return 0;
+}
+
+//**********************************************************************************************
+//benchmarks, run as "FINAL_CODE --bench <name> [graph file]"
+
+double secondsSince(std::chrono::steady_clock::time_point startTime) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+//uniform random directed edges, capacities in [1, maxCapacity]
+Graph* generateRandomGraph(size_t sizeVert, size_t sizeEdge, size_t maxCapacity, unsigned seed) {
+    std::mt19937_64 random(seed);
+    EdgeColumns edges;
+    edges.resize(sizeEdge);
+    for(size_t i = 0;i < sizeEdge; ++i) {
+        edges.start[i] = random() % sizeVert;
+        edges.finish[i] = random() % sizeVert;
+        edges.capacity[i] = random() % maxCapacity + 1;
+    }
+    return new Graph(sizeVert, edges);
+}
+
+//uniform random directed edges, capacities 2^k with k uniform in [0, 29]: every magnitude up to 1e9 equally likely
+Graph* generateWideCapacityGraph(size_t sizeVert, size_t sizeEdge, unsigned seed) {
+    std::mt19937_64 random(seed);
+    EdgeColumns edges;
+    edges.resize(sizeEdge);
+    for(size_t i = 0;i < sizeEdge; ++i) {
+        edges.start[i] = random() % sizeVert;
+        edges.finish[i] = random() % sizeVert;
+        edges.capacity[i] = static_cast<CapacityType>(1) << (random() % 30);
+    }
+    return new Graph(sizeVert, edges);
+}
+
+//rows x cols grid with edges both ways between neighbours, capacities 2^k with k uniform in [0, 29];
+//vertex 0 feeds the first column and the last column drains into the last vertex, both with unbounded edges
+Graph* generateWideCapacityGrid(size_t rows, size_t cols, unsigned seed) {
+    std::mt19937_64 random(seed);
+    size_t sizeVert = rows * cols + 2;
+    EdgeColumns edges;
+    DirectEdge edge;
+    for(size_t row = 0;row < rows; ++row) {
+        for(size_t col = 0;col < cols; ++col) {
+            IndexType cell = row * cols + col + 1;
+            if(col + 1 < cols) {
+                edge.start = cell;
+                edge.finish = cell + 1;
+                edge.capacity = static_cast<CapacityType>(1) << (random() % 30);
+                edges.push_back(edge);
+                std::swap(edge.start, edge.finish);
+                edge.capacity = static_cast<CapacityType>(1) << (random() % 30);
+                edges.push_back(edge);
+            }
+            if(row + 1 < rows) {
+                edge.start = cell;
+                edge.finish = cell + cols;
+                edge.capacity = static_cast<CapacityType>(1) << (random() % 30);
+                edges.push_back(edge);
+                std::swap(edge.start, edge.finish);
+                edge.capacity = static_cast<CapacityType>(1) << (random() % 30);
+                edges.push_back(edge);
+            }
         }
+        edge.capacity = static_cast<CapacityType>(1) << 30;
+        edge.start = 0;
+        edge.finish = row * cols + 1;
+        edges.push_back(edge);
+        edge.start = (row + 1) * cols;
+        edge.finish = sizeVert - 1;
+        edges.push_back(edge);
     }
-    
-    shortPathNetwork = new ShortPathNetwork(new Graph(network->graph->sizeVert, shortPathEdges),
-                                            network->source, network->sink, *edgeID);
-    return true;
+    return new Graph(sizeVert, edges);
 }
 
-bool DinicFlowFinder::checkEdgeForShortPath(size_t edgeNumber, DirectEdge& edge) {
-    if((*bfs.dist)[edge.start] + 1 == (*bfs.dist)[edge.finish] && network->flow[edgeNumber] < edge.capacity && edge.start != network->sink) {
-        edge.capacity -= network->flow[edgeNumber];
-        return true;
+//layerCount layers of layerWidth vertices, each with degree edges to random vertices of the next layer;
+//vertex 0 feeds the first layer and the last layer drains into the last vertex, capacities in [1, maxCapacity]
+Graph* generateLayeredGraph(size_t layerCount, size_t layerWidth, size_t degree, size_t maxCapacity, unsigned seed) {
+    std::mt19937_64 random(seed);
+    size_t sizeVert = layerCount * layerWidth + 2;
+    EdgeColumns edges;
+    DirectEdge edge;
+    for(size_t i = 0;i < layerWidth; ++i) {
+        edge.capacity = maxCapacity * degree;
+        edge.start = 0;
+        edge.finish = i + 1;
+        edges.push_back(edge);
+        edge.start = (layerCount - 1) * layerWidth + i + 1;
+        edge.finish = sizeVert - 1;
+        edges.push_back(edge);
     }
-    
-    if((*bfs.dist)[edge.finish] + 1 == (*bfs.dist)[edge.start] &&  network->flow[edgeNumber] > 0 && edge.finish != network->sink) {
-        std::swap(edge.start, edge.finish);
-        edge.capacity = network->flow[edgeNumber];
-        return true;
+    for(size_t layer = 0;layer + 1 < layerCount; ++layer) {
+        for(size_t i = 0;i < layerWidth; ++i) {
+            for(size_t j = 0;j < degree; ++j) {
+                edge.start = layer * layerWidth + i + 1;
+                edge.finish = (layer + 1) * layerWidth + random() % layerWidth + 1;
+                edge.capacity = random() % maxCapacity + 1;
+                edges.push_back(edge);
+            }
+        }
     }
-    
-    return false;
+    return new Graph(sizeVert, edges);
 }
 
-Bfs::Bfs() {
-    used = nullptr;
-    dist = nullptr;
+//a path of handleLength wide edges from vertex 0, its end fanning out into bristleCount unit edges to the last
+//vertex: one level graph where every augmenting path shares the long handle
+Graph* generateBroomGraph(size_t handleLength, size_t bristleCount) {
+    size_t sizeVert = handleLength + bristleCount + 2;
+    EdgeColumns edges;
+    DirectEdge edge;
+    edge.capacity = bristleCount;
+    for(size_t i = 0;i < handleLength; ++i) {
+        edge.start = i;
+        edge.finish = i + 1;
+        edges.push_back(edge);
+    }
+    edge.capacity = 1;
+    for(size_t i = 0;i < bristleCount; ++i) {
+        edge.start = handleLength;
+        edge.finish = handleLength + 1 + i;
+        edges.push_back(edge);
+        edge.start = handleLength + 1 + i;
+        edge.finish = sizeVert - 1;
+        edges.push_back(edge);
+    }
+    return new Graph(sizeVert, edges);
 }
 
-Bfs::~Bfs() {
-    delete used;
-    delete dist;
+//rows x cols pixels of a segmentation: edges both ways between 4-neighbours with capacities in [10, 29], and each
+//pixel tied to one terminal by the difference of its source and sink likelihoods, which are higher for the source
+//inside a few random discs and noisy everywhere. Vertex 0 is the source and the last vertex the sink
+Graph* generateSegmentationGrid(size_t rows, size_t cols, unsigned seed) {
+    std::mt19937_64 random(seed);
+    size_t sizeVert = rows * cols + 2;
+    const size_t discCount = 8;
+    long long discRow[discCount], discCol[discCount], discRadius[discCount];
+    for(size_t i = 0;i < discCount; ++i) {
+        discRow[i] = random() % rows;
+        discCol[i] = random() % cols;
+        discRadius[i] = random() % (min(rows, cols) / 4 + 1) + 1;
+    }
+    EdgeColumns edges;
+    size_t maxEdges = 2 * (rows * (cols - 1) + (rows - 1) * cols) + rows * cols;
+    edges.start.reserve(maxEdges);
+    edges.finish.reserve(maxEdges);
+    edges.capacity.reserve(maxEdges);
+    DirectEdge edge;
+    for(size_t row = 0;row < rows; ++row) {
+        for(size_t col = 0;col < cols; ++col) {
+            IndexType cell = row * cols + col + 1;
+            if(col + 1 < cols) {
+                edge.start = cell;
+                edge.finish = cell + 1;
+                edge.capacity = random() % 20 + 10;
+                edges.push_back(edge);
+                std::swap(edge.start, edge.finish);
+                edges.push_back(edge);
+            }
+            if(row + 1 < rows) {
+                edge.start = cell;
+                edge.finish = cell + cols;
+                edge.capacity = random() % 20 + 10;
+                edges.push_back(edge);
+                std::swap(edge.start, edge.finish);
+                edges.push_back(edge);
+            }
+            bool inside = false;
+            for(size_t i = 0;i < discCount; ++i) {
+                long long rowOffset = static_cast<long long>(row) - discRow[i];
+                long long colOffset = static_cast<long long>(col) - discCol[i];
+                inside = inside || rowOffset * rowOffset + colOffset * colOffset <= discRadius[i] * discRadius[i];
+            }
+            long long sourceLikelihood = (inside ? 60 : 20) + static_cast<long long>(random() % 41);
+            long long sinkLikelihood = 100 - sourceLikelihood;
+            if(sourceLikelihood != sinkLikelihood) {
+                edge.start = sourceLikelihood > sinkLikelihood ? 0 : cell;
+                edge.finish = sourceLikelihood > sinkLikelihood ? cell : sizeVert - 1;
+                edge.capacity = sourceLikelihood > sinkLikelihood ? sourceLikelihood - sinkLikelihood : sinkLikelihood - sourceLikelihood;
+                edges.push_back(edge);
+            }
+        }
+    }
+    return new Graph(sizeVert, edges);
 }
 
-void Bfs::init(Network* network) {
-    size_t sizeVert = network->graph->sizeVert;
-    if(!used) {
-        used = new vector <bool> (sizeVert);
-        dist = new vector <size_t> (sizeVert);
+//matching network: vertex 0 feeds leftCount left vertices, each with degree edges to random right vertices, and the
+//rightCount right vertices drain into the last vertex; every edge has the given capacity
+Graph* generateBipartiteGraph(size_t leftCount, size_t rightCount, size_t degree, CapacityType capacity, unsigned seed) {
+    std::mt19937_64 random(seed);
+    size_t sizeVert = leftCount + rightCount + 2;
+    EdgeColumns edges;
+    DirectEdge edge;
+    edge.capacity = capacity;
+    for(size_t i = 0;i < leftCount; ++i) {
+        edge.start = 0;
+        edge.finish = i + 1;
+        edges.push_back(edge);
+        for(size_t j = 0;j < degree; ++j) {
+            edge.start = i + 1;
+            edge.finish = leftCount + random() % rightCount + 1;
+            edges.push_back(edge);
+        }
     }
-    
-    vector <bool>::iterator usedIt = used->begin();
-    vector <size_t>::iterator distIt = dist->begin();
-    for(;usedIt != used->end(); ++usedIt, ++distIt) {
-        *usedIt = false;
-        *distIt = INF;
+    for(size_t i = 0;i < rightCount; ++i) {
+        edge.start = leftCount + i + 1;
+        edge.finish = sizeVert - 1;
+        edges.push_back(edge);
     }
-    this->network = network;
+    return new Graph(sizeVert, edges);
 }
 
-void Bfs::checkOutgoingEdges(size_t vert, size_t levelDist) {
-    size_t numEdge;
-    for(size_t i = 0;i < graph->outgoingList[vert].size();++i) {
-        numEdge = graph->outgoingList[vert][i];
-        curEdge = (graph->edgeList)[numEdge];
-        if(!(*used)[curEdge.finish] && network->flow[numEdge] < curEdge.capacity) {
-            (*used)[curEdge.finish] = true;
-            (*dist)[curEdge.finish] = levelDist;
-            bfsQueue.push(std::make_pair(curEdge.finish, levelDist));
+//chains of lengths 1..chainCount from vertex 0 to the last vertex: every Dinic phase saturates one chain,
+//so there are chainCount phases
+Graph* generateChainGraph(size_t chainCount) {
+    size_t sizeVert = chainCount * (chainCount - 1) / 2 + 2;
+    EdgeColumns edges;
+    edges.resize(chainCount * (chainCount + 1) / 2);
+    size_t edge = 0;
+    size_t vert = 1;
+    for(size_t length = 1;length <= chainCount; ++length) {
+        size_t prevVert = 0;
+        for(size_t i = 1;i < length; ++i, ++vert) {
+            edges.start[edge] = prevVert;
+            edges.finish[edge] = vert;
+            edges.capacity[edge++] = 1;
+            prevVert = vert;
         }
+        edges.start[edge] = prevVert;
+        edges.finish[edge] = sizeVert - 1;
+        edges.capacity[edge++] = 1;
     }
+    return new Graph(sizeVert, edges);
 }
 
-void Bfs::checkIncomingEdges(size_t vert, size_t levelDist) {
-    size_t numEdge;
-    for(size_t i = 0;i < graph->incomingList[vert].size();++i) {
-        numEdge = graph->incomingList[vert][i];
-        curEdge = graph->edgeList[numEdge];
-        if(!(*used)[curEdge.start] && network->flow[numEdge] > 0) {
-            (*used)[curEdge.start] = true;
-            (*dist)[curEdge.start] = levelDist;
-            bfsQueue.push(std::make_pair(curEdge.start, levelDist));
+//Bfs::run over the adjacency Graph used before CSR: one heap vector per vertex and direction
+void vectorOfVectorsBfs(Graph* graph, vector <vector <size_t> >& outgoing, vector <vector <size_t> >& incoming,
+                        vector <CapacityType>& flow, vector <bool>& used, vector <IndexType>& dist) {
+    queue <pair <size_t, size_t> > bfsQueue;
+    used.assign(graph->sizeVert, false);
+    dist.assign(graph->sizeVert, UNREACHED);
+    dist[0] = 0;
+    used[0] = true;
+    bfsQueue.push(std::make_pair(0, 0));
+    while(!bfsQueue.empty()) {
+        size_t vert = bfsQueue.front().first;
+        size_t levelDist = bfsQueue.front().second + 1;
+        bfsQueue.pop();
+        if(vert == graph->sizeVert - 1) {
+            continue;
+        }
+        for(size_t i = 0;i < outgoing[vert].size(); ++i) {
+            size_t numEdge = outgoing[vert][i];
+            size_t nextVert = graph->edgeFinish[numEdge];
+            if(!used[nextVert] && flow[numEdge] < graph->edgeCapacity[numEdge]) {
+                used[nextVert] = true;
+                dist[nextVert] = levelDist;
+                bfsQueue.push(std::make_pair(nextVert, levelDist));
+            }
+        }
+        for(size_t i = 0;i < incoming[vert].size(); ++i) {
+            size_t numEdge = incoming[vert][i];
+            size_t nextVert = graph->edgeStart[numEdge];
+            if(!used[nextVert] && flow[numEdge] > 0) {
+                used[nextVert] = true;
+                dist[nextVert] = levelDist;
+                bfsQueue.push(std::make_pair(nextVert, levelDist));
+            }
         }
     }
 }
 
-bool Bfs::run() {
-    size_t vert;
-    size_t levelDist;
+void benchmarkBfs(Graph* graph, const string& name) {
+    Network network(graph, 0, graph->sizeVert - 1);
+    size_t repeats = max(static_cast<size_t>(3), static_cast<size_t>(50000000) / (graph->sizeVert + graph->sizeEdge));
     
-    graph = network->graph;
-    source = network->source;
-    sink = network->sink;
+    vector <vector <size_t> > outgoing(graph->sizeVert);
+    vector <vector <size_t> > incoming(graph->sizeVert);
+    for(size_t i = 0;i < graph->sizeEdge; ++i) {
+        outgoing[graph->edgeStart[i]].push_back(i);
+        incoming[graph->edgeFinish[i]].push_back(i);
+    }
+    vector <bool> referenceUsed;
+    vector <IndexType> referenceDist;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    for(size_t i = 0;i < repeats; ++i) {
+        vectorOfVectorsBfs(graph, outgoing, incoming, network.flow, referenceUsed, referenceDist);
+    }
+    double referenceSeconds = secondsSince(startTime) / repeats;
     
-    (*dist)[source] = 0;
-    (*used)[source] = true;
-    bfsQueue.push(std::make_pair(source, 0));
+    Bfs bfs;
+    startTime = std::chrono::steady_clock::now();
+    for(size_t i = 0;i < repeats; ++i) {
+        bfs.init(&network);
+        bfs.run();
+    }
+    double csrSeconds = secondsSince(startTime) / repeats;
     
-    while(!bfsQueue.empty()) {
-        vert = bfsQueue.front().first;
-        levelDist = bfsQueue.front().second;
-        bfsQueue.pop();
-        
-        if(vert == sink) {
-            continue;
+    cout << "bfs " << name << ": V=" << graph->sizeVert << " E=" << graph->sizeEdge
+         << " vector-of-vectors " << referenceSeconds * 1000 << " ms, csr " << csrSeconds * 1000 << " ms, speedup "
+         << referenceSeconds / csrSeconds << (referenceDist == *bfs.dist ? "" : " (DIST MISMATCH)") << endl;
+}
+
+//per-edge "cout << flow << endl" against the bulk writers, on random flows of a 20M-edge graph
+void benchmarkFlowWrite(ThreadPool& pool) {
+    Network network(generateRandomGraph(1000000, 20000000, 1000000000, 2), 0, 999999);
+    std::mt19937 random(3);
+    for(size_t i = 0;i < network.flow.size(); ++i) {
+        network.flow[i] = random() % (network.graph->edgeCapacity[i] + 1);
+    }
+    const char* path = "flow_benchmark.tmp";
+    
+    const size_t endlEdges = 1000000;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    {
+        ofstream out(path);
+        for(size_t i = 0;i < endlEdges; ++i) {
+            out << network.flow[i] << endl;
         }
-        
-        ++levelDist;
-        
-        checkOutgoingEdges(vert, levelDist);
-        checkIncomingEdges(vert, levelDist);
     }
+    double endlSeconds = secondsSince(startTime) * network.flow.size() / endlEdges;
     
-    return (*used)[sink];
+    startTime = std::chrono::steady_clock::now();
+    writeFlowText(path, network, nullptr);
+    double textSeconds = secondsSince(startTime);
+    startTime = std::chrono::steady_clock::now();
+    writeFlowText(path, network, &pool);
+    double parallelTextSeconds = secondsSince(startTime);
+    startTime = std::chrono::steady_clock::now();
+    writeFlowBinary(path, network);
+    double binarySeconds = secondsSince(startTime);
+    remove(path);
+    
+    cout << "flow write, " << network.flow.size() << " edges: endl per line " << endlSeconds * 1000
+         << " ms (extrapolated from " << endlEdges << "), bulk text " << textSeconds * 1000 << " ms, bulk text on "
+         << pool.size() << " threads " << parallelTextSeconds * 1000 << " ms, binary " << binarySeconds * 1000 << " ms" << endl;
 }
 
-ShortPathNetwork::ShortPathNetwork(Graph* graph, size_t source, size_t sink, vector <size_t>& edgeID):
-Network(graph, source, sink), edgeID(edgeID){
+//EdgeListParser::parse against parseParallel on 4 threads: both must accept the same inputs, with the same edges.
+//Returns the number of inputs they disagree on
+size_t checkEdgeListParser() {
+    struct Case {
+        string text;
+        bool valid;
+    };
+    vector <Case> cases;
+    Case small[] = {
+        {"3 2\n1 2 5\n2 3 3\n", true},
+        {"3 2\r\n1 2 5\r\n2 3 3", true},
+        {"3 2 1 2 5\n2 3 3\n", true},
+        {"3 2\n1 2 5\n2 3 3\n1 3 7\n", false},
+        {"3 2\n1 2 5 2 3 5\n", false},
+        {"3 2\n1 2 5\n2 3 3 1 3 7\n", false},
+        {"3 2\n1 2\n5\n2 3 3\n", false},
+        {"3 2\n1 2 5\n", false},
+        {"3 2\n1 2 5\n2 4 3\n", false},
+        {"3 1\n1 2 99999999999999999999999\n", false},
+        {"c x\np max 3 2\nn 1 s\nn 3 t\na 1 2 5\nc y\na 2 3 3\n", true},
+        {"p max 3 2\nn 1 s\nn 3 t\na 1 2 5 a 2 3 3\n", false},
+        {"p max 3 2\nn 1 s\nn 3 t\na 1 2\n5\na 2 3 3\n", false}
+    };
+    cases.assign(small, small + sizeof(small) / sizeof(small[0]));
+    //a few megabytes, so parseParallel really splits the input into chunks
+    const size_t bigEdges = 400000;
+    std::mt19937 random(25);
+    string big = "1000 " + to_string(bigEdges) + "\n";
+    for(size_t i = 0;i < bigEdges; ++i) {
+        big += to_string(random() % 1000 + 1) + " " + to_string(random() % 1000 + 1) + " " + to_string(random() % 1000000) + "\n";
+    }
+    Case bigValid = {big, true};
+    cases.push_back(bigValid);
+    size_t middle = big.find('\n', big.size() / 2);
+    Case bigJoined = {big.substr(0, middle) + " " + big.substr(middle + 1) + "1 1 1\n", false};
+    cases.push_back(bigJoined);
+    
+    ThreadPool pool(4);
+    size_t mismatches = 0;
+    for(size_t i = 0;i < cases.size(); ++i) {
+        const char* begin = cases[i].text.data();
+        const char* end = begin + cases[i].text.size();
+        GraphFormat format = detectGraphFormat(begin, end - begin);
+        EdgeListParser serialParser(begin, end, format);
+        EdgeListParser parallelParser(begin, end, format);
+        size_t serialVert = 0, parallelVert = 0;
+        EdgeColumns serialEdges, parallelEdges;
+        bool serialParsed = serialParser.parse(serialVert, serialEdges);
+        bool parallelParsed = parallelParser.parseParallel(pool, parallelVert, parallelEdges);
+        bool mismatch = serialParsed != cases[i].valid || parallelParsed != cases[i].valid;
+        if(serialParsed && parallelParsed) {
+            mismatch = mismatch || serialVert != parallelVert || serialEdges.start != parallelEdges.start
+                    || serialEdges.finish != parallelEdges.finish || serialEdges.capacity != parallelEdges.capacity;
+        }
+        if(mismatch) {
+            cout << "  input " << i << ": serial " << (serialParsed ? "accepts" : serialParser.error) << ", parallel "
+                 << (parallelParsed ? "accepts" : parallelParser.error) << ", expected to " << (cases[i].valid ? "accept" : "reject") << endl;
+        }
+        mismatches += mismatch;
+    }
+    cout << "edge list parser on " << cases.size() << " inputs, serial and on 4 threads: " << mismatches
+         << (mismatches ? " MISMATCHES" : " mismatches") << endl;
+    return mismatches;
 }
 
-ShortPathNetwork::~ShortPathNetwork() {
-    delete &edgeID;
-    //delete graph;
+//whole Dinic runs with copied short path networks against the level graph view
+void benchmarkLevelGraph(Graph* graph, const string& name) {
+    LinkCutBlockFlowFinder linkCutBlockflowFinder(graph->sizeVert, 0, graph->sizeVert - 1);
+    Network network(graph, 0, graph->sizeVert - 1);
+    double seconds[2];
+    CapacityType maxFlow[2];
+    for(int view = 0;view < 2; ++view) {
+        DinicFlowFinder dinicFlowFinder(&linkCutBlockflowFinder, view == 1);
+        network.reset(0, graph->sizeVert - 1);
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        network.getMaxFlow(dinicFlowFinder);
+        seconds[view] = secondsSince(startTime);
+        maxFlow[view] = network.maxFlow;
+    }
+    cout << "level graph " << name << ": V=" << graph->sizeVert << " E=" << graph->sizeEdge << " copy "
+         << seconds[0] * 1000 << " ms, view " << seconds[1] * 1000 << " ms, speedup " << seconds[0] / seconds[1]
+         << (maxFlow[0] == maxFlow[1] ? "" : " (FLOW MISMATCH)") << endl;
 }
 
-LinkCutBlockFlowFinder::LinkCutBlockFlowFinder(size_t sizeVert, size_t source, size_t sink): linkCut(LinkCutTree(sizeVert)), source(source), sink(sink) {
-};
+//top-down against hybrid bfs: edges examined and time of one bfs on the zero flow, then edges examined per
+//phase of a whole Dinic run if runDinic
+void benchmarkHybridBfs(Graph* graph, const string& name, bool runDinic) {
+    Network network(graph, 0, graph->sizeVert - 1);
+    size_t repeats = max(static_cast<size_t>(3), static_cast<size_t>(50000000) / (graph->sizeVert + graph->sizeEdge));
+    const BfsMode modes[2] = {BFS_TOP_DOWN, BFS_HYBRID};
+    Bfs bfs[2];
+    double seconds[2];
+    for(int i = 0;i < 2; ++i) {
+        bfs[i].mode = modes[i];
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        for(size_t j = 0;j < repeats; ++j) {
+            bfs[i].init(&network);
+            bfs[i].run();
+        }
+        seconds[i] = secondsSince(startTime) / repeats;
+    }
+    cout << "hybrid bfs " << name << ": V=" << graph->sizeVert << " E=" << graph->sizeEdge << " zero flow: top-down "
+         << bfs[0].edgesExamined << " edges " << seconds[0] * 1000 << " ms, hybrid " << bfs[1].edgesExamined << " edges "
+         << seconds[1] * 1000 << " ms" << (*bfs[0].dist == *bfs[1].dist ? "" : " (DIST MISMATCH)") << endl;
+    if(!runDinic) {
+        return;
+    }
+    
+    LinkCutBlockFlowFinder linkCutBlockflowFinder(graph->sizeVert, 0, graph->sizeVert - 1);
+    for(int i = 0;i < 2; ++i) {
+        DinicFlowFinder dinicFlowFinder(&linkCutBlockflowFinder);
+        dinicFlowFinder.bfs.mode = modes[i];
+        network.reset(0, graph->sizeVert - 1);
+        network.getMaxFlow(dinicFlowFinder);
+        cout << "  dinic, " << (i ? "hybrid" : "top-down") << ": flow " << network.maxFlow << ", "
+             << dinicFlowFinder.phaseCount << " phases, " << dinicFlowFinder.bfsEdgesExamined / dinicFlowFinder.phaseCount
+             << " edges examined per phase" << endl;
+    }
+}
 
-LinkCutBlockFlowFinder::~LinkCutBlockFlowFinder() {
-    //delete &linkCut;
+//BFS_PARALLEL at 1, 2, 4, 8 and 16 threads against the serial hybrid bfs, one bfs on the zero flow
+void benchmarkParallelBfs(Graph* graph, const string& name) {
+    Network network(graph, 0, graph->sizeVert - 1);
+    size_t repeats = max(static_cast<size_t>(3), static_cast<size_t>(50000000) / (graph->sizeVert + graph->sizeEdge));
+    Bfs serialBfs;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    for(size_t i = 0;i < repeats; ++i) {
+        serialBfs.init(&network);
+        serialBfs.run();
+    }
+    double serialSeconds = secondsSince(startTime) / repeats;
+    cout << "parallel bfs " << name << ": V=" << graph->sizeVert << " E=" << graph->sizeEdge << " (" << std::thread::hardware_concurrency()
+         << " hardware threads), serial hybrid " << serialSeconds * 1000 << " ms" << endl;
+    
+    for(size_t threadCount = 1;threadCount <= 16; threadCount *= 2) {
+        ThreadPool pool(threadCount);
+        Bfs bfs;
+        bfs.mode = BFS_PARALLEL;
+        bfs.pool = &pool;
+        startTime = std::chrono::steady_clock::now();
+        for(size_t i = 0;i < repeats; ++i) {
+            bfs.init(&network);
+            bfs.run();
+        }
+        double seconds = secondsSince(startTime) / repeats;
+        cout << "  " << threadCount << " threads: " << seconds * 1000 << " ms, speedup " << serialSeconds / seconds
+             << (*bfs.dist == *serialBfs.dist && *bfs.used == *serialBfs.used ? "" : " (DIST MISMATCH)") << endl;
+    }
 }
 
-void LinkCutBlockFlowFinder::addEdge(size_t vertex, size_t nextVert, vector <vector <size_t> >& outEdges, vector <DirectEdge>& edgeList) {
-    linkCut.setWeight(vertex, edgeList[outEdges[vertex][curEdgeNumber[vertex]]].capacity);
-    linkCut.link(vertex, nextVert);
-    linkCut.findRoot(source);
-    linkCut.setWeight(linkCut.findRoot(source)->key, INF);
-    edgeInsideTreeFlag[vertex] = true;
+//level graph arcs per phase and Dinic time without and with sink-side pruning
+void benchmarkPruning(Graph* graph, const string& name) {
+    LinkCutBlockFlowFinder linkCutBlockflowFinder(graph->sizeVert, 0, graph->sizeVert - 1);
+    Network network(graph, 0, graph->sizeVert - 1);
+    vector <size_t> arcCounts[2];
+    double seconds[2];
+    CapacityType maxFlow[2];
+    for(int prune = 0;prune < 2; ++prune) {
+        DinicFlowFinder dinicFlowFinder(&linkCutBlockflowFinder);
+        dinicFlowFinder.pruneLevelGraph = prune == 1;
+        dinicFlowFinder.countLevelArcs = true;
+        network.reset(0, graph->sizeVert - 1);
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        network.getMaxFlow(dinicFlowFinder);
+        seconds[prune] = secondsSince(startTime);
+        maxFlow[prune] = network.maxFlow;
+        arcCounts[prune] = dinicFlowFinder.levelArcCounts;
+    }
+    size_t totals[2] = {0, 0};
+    for(int prune = 0;prune < 2; ++prune) {
+        for(size_t i = 0;i < arcCounts[prune].size(); ++i) {
+            totals[prune] += arcCounts[prune][i];
+        }
+    }
+    cout << "pruning " << name << ": V=" << graph->sizeVert << " E=" << graph->sizeEdge << ", level graph arcs "
+         << totals[0] << " in " << arcCounts[0].size() << " phases -> " << totals[1] << " in " << arcCounts[1].size()
+         << " phases (" << 100.0 * totals[1] / max(totals[0], static_cast<size_t>(1)) << "%), time " << seconds[0] * 1000
+         << " ms -> " << seconds[1] * 1000 << " ms" << (maxFlow[0] == maxFlow[1] ? "" : " (FLOW MISMATCH)") << endl;
+    const size_t shownPhases = 20;
+    for(size_t i = 0;i < min(min(arcCounts[0].size(), arcCounts[1].size()), shownPhases); ++i) {
+        cout << "  phase " << i + 1 << ": " << arcCounts[0][i] << " -> " << arcCounts[1][i] << endl;
+    }
 }
 
-void LinkCutBlockFlowFinder::removeEdge(size_t vertex, size_t prevVert, vector <vector <size_t> >& outEdges, vector <DirectEdge>& edgeList) {
-    linkCut.cut(prevVert, vertex);
-    edgeList[outEdges[prevVert][curEdgeNumber[prevVert]]].capacity = linkCut.getEdgeWeight(prevVert);
-    linkCut.setWeight(prevVert, INF);
-    ++curEdgeNumber[prevVert];
-    edgeInsideTreeFlag[prevVert] = false;
+//phases and time of Dinic against Dinic with capacity scaling
+void benchmarkScaling(Graph* graph, const string& name) {
+    LinkCutBlockFlowFinder linkCutBlockflowFinder(graph->sizeVert, 0, graph->sizeVert - 1);
+    Network network(graph, 0, graph->sizeVert - 1);
+    DinicFlowFinder dinicFlowFinder(&linkCutBlockflowFinder);
+    ScalingDinicFlowFinder scalingFlowFinder(&linkCutBlockflowFinder);
+    DinicFlowFinder* flowFinders[2] = {&dinicFlowFinder, &scalingFlowFinder};
+    double seconds[2];
+    CapacityType maxFlow[2];
+    for(int i = 0;i < 2; ++i) {
+        network.reset(0, graph->sizeVert - 1);
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        network.getMaxFlow(*flowFinders[i]);
+        seconds[i] = secondsSince(startTime);
+        maxFlow[i] = network.maxFlow;
+    }
+    cout << "scaling " << name << ": V=" << graph->sizeVert << " E=" << graph->sizeEdge << ", dinic "
+         << dinicFlowFinder.phaseCount << " phases " << seconds[0] * 1000 << " ms, scaling dinic "
+         << scalingFlowFinder.phaseCount << " phases in " << scalingFlowFinder.roundCount << " rounds "
+         << seconds[1] * 1000 << " ms, speedup " << seconds[0] / seconds[1]
+         << (maxFlow[0] == maxFlow[1] ? "" : " (FLOW MISMATCH)") << endl;
 }
 
-void LinkCutBlockFlowFinder::decreaseWeightsInPath(Node* minEdge, vector <vector <size_t> >& outEdges, vector <DirectEdge>& edgeList) {
-    size_t minVert;
-    linkCut.removeWeightInPath(minEdge->edgeWeight, source);
-    while(linkCut.getEdgeWeight((minEdge = linkCut.getMinEdge(source))->key) == 0) {
-        minVert = minEdge->key;
-        edgeList[outEdges[minVert][curEdgeNumber[minVert]]].capacity = 0;
-        linkCut.cut(minVert, edgeList[outEdges[minVert][curEdgeNumber[minVert]]].finish);
-        linkCut.setWeight(minVert, INF);
-        ++curEdgeNumber[minVert];
-        edgeInsideTreeFlag[minVert] = false;
-        if(minVert == source) {
-            break;
+//Dinic with the link-cut blocking flow against the current-arc dfs
+void benchmarkBlockFlow(Graph* graph, const string& name) {
+    LinkCutBlockFlowFinder linkCutBlockflowFinder(graph->sizeVert, 0, graph->sizeVert - 1);
+    DfsBlockFlowFinder dfsBlockFlowFinder;
+    BlockFlowFinder* blockFlowFinders[2] = {&linkCutBlockflowFinder, &dfsBlockFlowFinder};
+    Network network(graph, 0, graph->sizeVert - 1);
+    double seconds[2];
+    CapacityType maxFlow[2];
+    for(int i = 0;i < 2; ++i) {
+        DinicFlowFinder dinicFlowFinder(blockFlowFinders[i]);
+        network.reset(0, graph->sizeVert - 1);
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        network.getMaxFlow(dinicFlowFinder);
+        seconds[i] = secondsSince(startTime);
+        maxFlow[i] = network.maxFlow;
+    }
+    cout << "block flow " << name << ": V=" << graph->sizeVert << " E=" << graph->sizeEdge << " (" << graph->sizeEdge / graph->sizeVert
+         << " per vertex), link-cut " << seconds[0] * 1000 << " ms, dfs " << seconds[1] * 1000 << " ms, "
+         << (seconds[0] < seconds[1] ? "link-cut" : "dfs") << " wins by " << max(seconds[0], seconds[1]) / min(seconds[0], seconds[1])
+         << (maxFlow[0] == maxFlow[1] ? "" : " (FLOW MISMATCH)") << endl;
+}
+
+//Dinic with both blocking flow finders against push-relabel, with and without its second phase
+void benchmarkPushRelabel(Graph* graph, const string& name) {
+    LinkCutBlockFlowFinder linkCutBlockflowFinder(graph->sizeVert, 0, graph->sizeVert - 1);
+    DfsBlockFlowFinder dfsBlockFlowFinder;
+    DinicFlowFinder linkCutDinic(&linkCutBlockflowFinder);
+    DinicFlowFinder dfsDinic(&dfsBlockFlowFinder);
+    PushRelabelFlowFinder pushRelabel;
+    PushRelabelFlowFinder minCutPushRelabel;
+    minCutPushRelabel.minCutOnly = true;
+    FlowFinder* flowFinders[4] = {&linkCutDinic, &dfsDinic, &pushRelabel, &minCutPushRelabel};
+    const char* names[4] = {"dinic link-cut", "dinic dfs", "push-relabel", "push-relabel min cut only"};
+    Network network(graph, 0, graph->sizeVert - 1);
+    
+    cout << "push-relabel " << name << ": V=" << graph->sizeVert << " E=" << graph->sizeEdge << endl;
+    long long maxFlow = 0;
+    for(int i = 0;i < 4; ++i) {
+        network.reset(0, graph->sizeVert - 1);
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        network.getMaxFlow(*flowFinders[i]);
+        double seconds = secondsSince(startTime);
+        if(i == 0) {
+            maxFlow = network.maxFlow;
         }
+        cout << "  " << names[i] << ": " << seconds * 1000 << " ms" << (network.maxFlow == maxFlow ? "" : " (FLOW MISMATCH)") << endl;
     }
+    cout << "  push-relabel: " << pushRelabel.pushCount << " pushes, " << pushRelabel.relabelCount << " relabels, "
+         << pushRelabel.globalRelabelCount << " global relabels, " << pushRelabel.gapCount << " gaps" << endl;
 }
 
-void LinkCutBlockFlowFinder::updateBlockFlow(vector <size_t>& flow, vector <vector <size_t> >& outEdges, vector <DirectEdge>& edgeList) {
-    DirectEdge curEdge;
-    for(size_t i = 0;i < flow.size(); ++i) {
-        curEdge = edgeList[i];
-        if(curEdgeNumber[curEdge.start] != outEdges[curEdge.start].size()
-           && outEdges[curEdge.start][curEdgeNumber[curEdge.start]] == i && edgeInsideTreeFlag[curEdge.start]) {
-            (flow)[i] -= linkCut.getEdgeWeight(edgeList[i].start);
+//ParallelPushRelabelFlowFinder at 1, 2, 4, 8 and 16 threads against the serial push-relabel and Dinic
+void benchmarkParallelPushRelabel(Graph* graph, const string& name) {
+    Network network(graph, 0, graph->sizeVert - 1);
+    DfsBlockFlowFinder dfsBlockFlowFinder;
+    DinicFlowFinder dinicFlowFinder(&dfsBlockFlowFinder);
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    network.getMaxFlow(dinicFlowFinder);
+    double dinicSeconds = secondsSince(startTime);
+    long long maxFlow = network.maxFlow;
+    PushRelabelFlowFinder pushRelabel;
+    network.reset(0, graph->sizeVert - 1);
+    startTime = std::chrono::steady_clock::now();
+    network.getMaxFlow(pushRelabel);
+    double serialSeconds = secondsSince(startTime);
+    cout << "parallel push-relabel " << name << ": V=" << graph->sizeVert << " E=" << graph->sizeEdge << " ("
+         << std::thread::hardware_concurrency() << " hardware threads), dinic " << dinicSeconds * 1000 << " ms, serial push-relabel "
+         << serialSeconds * 1000 << " ms" << (network.maxFlow == maxFlow ? "" : " (FLOW MISMATCH)") << endl;
+    
+    for(size_t threadCount = 1;threadCount <= 16; threadCount *= 2) {
+        ThreadPool pool(threadCount);
+        ParallelPushRelabelFlowFinder parallelPushRelabel(&pool);
+        network.reset(0, graph->sizeVert - 1);
+        startTime = std::chrono::steady_clock::now();
+        network.getMaxFlow(parallelPushRelabel);
+        double seconds = secondsSince(startTime);
+        cout << "  " << threadCount << " threads: " << seconds * 1000 << " ms, speedup " << serialSeconds / seconds << " over serial, "
+             << parallelPushRelabel.roundCount << " rounds, " << parallelPushRelabel.globalRelabelCount << " global relabels"
+             << (network.maxFlow == maxFlow ? "" : " (FLOW MISMATCH)") << endl;
+    }
+}
+
+//ParallelPushRelabelFlowFinder at 1, 4 and 16 threads against the serial push-relabel and Dinic on many small
+//random graphs (self-loops and parallel edges included), where unlucky label races show up, and a few dense ones,
+//where neighbours share many arcs; built with -fsanitize=thread this is the data race check of the engine.
+//Returns the number of graphs with a mismatch
+size_t checkParallelPushRelabel(size_t graphCount, size_t denseCount, unsigned seed) {
+    std::mt19937_64 random(seed);
+    ThreadPool onePool(1);
+    ThreadPool fourPool(4);
+    ThreadPool sixteenPool(16);
+    ThreadPool* pools[3] = {&onePool, &fourPool, &sixteenPool};
+    size_t mismatches = 0;
+    for(size_t i = 0;i < graphCount + denseCount; ++i) {
+        Graph* graph;
+        if(i < graphCount) {
+            size_t sizeVert = random() % 40 + 2;
+            size_t capacities[4] = {1, 5, 100, 1000000};
+            graph = generateRandomGraph(sizeVert, random() % (sizeVert * 6) + 1, capacities[random() % 4], random());
         } else {
-            (flow)[i] -= edgeList[i].capacity;
+            graph = generateRandomGraph(400, 40000, 1000, random());
+        }
+        Network network(graph, 0, graph->sizeVert - 1);
+        DfsBlockFlowFinder dfsBlockFlowFinder;
+        DinicFlowFinder dinicFlowFinder(&dfsBlockFlowFinder);
+        network.getMaxFlow(dinicFlowFinder);
+        long long maxFlow = network.maxFlow;
+        PushRelabelFlowFinder pushRelabel;
+        network.reset(0, graph->sizeVert - 1);
+        network.getMaxFlow(pushRelabel);
+        bool mismatch = network.maxFlow != maxFlow;
+        for(int p = 0;p < 3; ++p) {
+            ParallelPushRelabelFlowFinder parallelPushRelabel(pools[p]);
+            network.reset(0, graph->sizeVert - 1);
+            network.getMaxFlow(parallelPushRelabel);
+            mismatch = mismatch || network.maxFlow != maxFlow;
         }
+        mismatches += mismatch;
     }
-
+    cout << "parallel push-relabel on " << graphCount << " small and " << denseCount << " dense random graphs at 1, 4 and 16 threads: "
+         << mismatches << (mismatches ? " FLOW MISMATCHES" : " mismatches") << endl;
+    return mismatches;
 }
 
-void LinkCutBlockFlowFinder::findBlockFlow() {
-    curEdgeNumber.clear();
-    edgeInsideTreeFlag.clear();
-    curEdgeNumber.resize(shortPathNetwork->graph->sizeVert, false);
-    edgeInsideTreeFlag.resize(shortPathNetwork->graph->sizeVert, false);
-    vector <vector <size_t> >& outEdges = shortPathNetwork->graph->outgoingList;
-    vector <DirectEdge>& edgeList = shortPathNetwork->graph->edgeList;
-    vector <size_t>& flow = shortPathNetwork->flow;
-    
-    size_t vertex;
-    size_t nextVert;
-    size_t prevVert;
+//BoykovKolmogorovFlowFinder against push-relabel and Dinic with the dfs blocking flow
+void benchmarkBoykovKolmogorov(Graph* graph, const string& name) {
+    DfsBlockFlowFinder dfsBlockFlowFinder;
+    DinicFlowFinder dinicFlowFinder(&dfsBlockFlowFinder);
+    PushRelabelFlowFinder pushRelabel;
+    BoykovKolmogorovFlowFinder boykovKolmogorov;
+    FlowFinder* flowFinders[3] = {&boykovKolmogorov, &pushRelabel, &dinicFlowFinder};
+    const char* names[3] = {"boykov-kolmogorov", "push-relabel", "dinic dfs"};
+    Network network(graph, 0, graph->sizeVert - 1);
     
-    for(size_t i = 0;i < edgeList.size(); ++i) {
-        flow[i] = edgeList[i].capacity;
+    cout << "boykov-kolmogorov " << name << ": V=" << graph->sizeVert << " E=" << graph->sizeEdge << endl;
+    long long maxFlow = 0;
+    double bkSeconds = 0;
+    for(int i = 0;i < 3; ++i) {
+        network.reset(0, graph->sizeVert - 1);
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        network.getMaxFlow(*flowFinders[i]);
+        double seconds = secondsSince(startTime);
+        if(i == 0) {
+            maxFlow = network.maxFlow;
+            bkSeconds = seconds;
+            cout << "  " << names[i] << ": " << seconds * 1000 << " ms, flow " << maxFlow << ", " << boykovKolmogorov.augmentationCount
+                 << " augmentations, " << boykovKolmogorov.orphanCount << " orphans" << endl;
+        } else {
+            cout << "  " << names[i] << ": " << seconds * 1000 << " ms, boykov-kolmogorov speedup " << seconds / bkSeconds
+                 << (network.maxFlow == maxFlow ? "" : " (FLOW MISMATCH)") << endl;
+        }
     }
+}
+
+//PseudoflowFlowFinder against Dinic with the link-cut and the dfs blocking flow and against push-relabel
+void benchmarkPseudoflow(Graph* graph, const string& name) {
+    LinkCutBlockFlowFinder linkCutBlockflowFinder(graph->sizeVert, 0, graph->sizeVert - 1);
+    DfsBlockFlowFinder dfsBlockFlowFinder;
+    DinicFlowFinder linkCutDinic(&linkCutBlockflowFinder);
+    DinicFlowFinder dfsDinic(&dfsBlockFlowFinder);
+    PushRelabelFlowFinder pushRelabel;
+    PseudoflowFlowFinder pseudoflow;
+    FlowFinder* flowFinders[4] = {&linkCutDinic, &dfsDinic, &pushRelabel, &pseudoflow};
+    const char* names[4] = {"dinic link-cut", "dinic dfs", "push-relabel", "pseudoflow"};
+    Network network(graph, 0, graph->sizeVert - 1);
     
-    linkCut.clearTrees();
+    cout << "pseudoflow " << name << ": V=" << graph->sizeVert << " E=" << graph->sizeEdge << endl;
+    long long maxFlow = 0;
+    double linkCutSeconds = 0;
+    for(int i = 0;i < 4; ++i) {
+        network.reset(0, graph->sizeVert - 1);
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        network.getMaxFlow(*flowFinders[i]);
+        double seconds = secondsSince(startTime);
+        if(i == 0) {
+            maxFlow = network.maxFlow;
+            linkCutSeconds = seconds;
+        }
+        cout << "  " << names[i] << ": " << seconds * 1000 << " ms, speedup over dinic link-cut " << linkCutSeconds / seconds
+             << (network.maxFlow == maxFlow ? "" : " (FLOW MISMATCH)") << endl;
+    }
+    MinCut cut;
+    pseudoflow.getMinCut(cut);
+    cout << "  pseudoflow: " << pseudoflow.mergeCount << " merges, " << pseudoflow.relabelCount << " relabels, "
+         << pseudoflow.liftCount << " lifted trees, min cut " << cut.capacity << (cut.capacity == maxFlow ? "" : " (CUT MISMATCH)") << endl;
+}
+
+//UnitCapacityFlowFinder against Dinic with the link-cut and the dfs blocking flow, on graphs with equal capacities
+void benchmarkUnitCapacity(Graph* graph, const string& name) {
+    LinkCutBlockFlowFinder linkCutBlockflowFinder(graph->sizeVert, 0, graph->sizeVert - 1);
+    DfsBlockFlowFinder dfsBlockFlowFinder;
+    DinicFlowFinder linkCutDinic(&linkCutBlockflowFinder);
+    DinicFlowFinder dfsDinic(&dfsBlockFlowFinder);
+    UnitCapacityFlowFinder unitCapacity;
+    FlowFinder* flowFinders[3] = {&unitCapacity, &linkCutDinic, &dfsDinic};
+    const char* names[3] = {"unit capacity", "dinic link-cut", "dinic dfs"};
+    Network network(graph, 0, graph->sizeVert - 1);
     
-    while(true) {
-        if((vertex = linkCut.findRoot(source)->key) != sink) {
-            if(curEdgeNumber[vertex] != outEdges[vertex].size()) {
-                nextVert = edgeList[outEdges[vertex][curEdgeNumber[vertex]]].finish;
-                
-                addEdge(vertex, nextVert, outEdges, edgeList);//Step 1
-            } else {
-                if(vertex == source) {
-                    edgeInsideTreeFlag[source] = false;//Step 2
-                    break;
-                } else {
-                    prevVert = linkCut.prevInPath(source)->key;
-                    
-                    removeEdge(vertex, prevVert, outEdges, edgeList);//Step 3
-                }
-            }
+    cout << "unit capacity " << name << ": V=" << graph->sizeVert << " E=" << graph->sizeEdge << ", capacity "
+         << uniformCapacity(graph) << endl;
+    long long maxFlow = 0;
+    double unitSeconds = 0;
+    for(int i = 0;i < 3; ++i) {
+        network.reset(0, graph->sizeVert - 1);
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        network.getMaxFlow(*flowFinders[i]);
+        double seconds = secondsSince(startTime);
+        if(i == 0) {
+            maxFlow = network.maxFlow;
+            unitSeconds = seconds;
+            cout << "  " << names[i] << ": " << seconds * 1000 << " ms, flow " << maxFlow << " in " << unitCapacity.phaseCount << " phases" << endl;
         } else {
-            Node* minEdge = linkCut.getMinEdge(source);
-            
-            decreaseWeightsInPath(minEdge, outEdges, edgeList);//Step 4
+            cout << "  " << names[i] << ": " << seconds * 1000 << " ms, unit capacity speedup " << seconds / unitSeconds
+                 << (network.maxFlow == maxFlow ? "" : " (FLOW MISMATCH)") << endl;
         }
     }
+}
+
+//one path of length vertices in a LinkCutTree, linked the way LinkCutBlockFlowFinder links a long augmenting path,
+//then root, path minimum, weight removal and cut queries on it, which walk splay trees as deep as the path
+void benchmarkDeepPath(size_t length, unsigned seed) {
+    std::mt19937_64 random(seed);
+    LinkCutTree linkCut(length);
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    for(size_t i = 0;i + 1 < length; ++i) {
+        linkCut.setWeight(i, random() % 1000000 + 1);
+        linkCut.link(i, i + 1);
+    }
+    linkCut.setWeight(length - 1, INF);
+    double linkSeconds = secondsSince(startTime);
     
-    updateBlockFlow(flow, outEdges, edgeList);
+    startTime = std::chrono::steady_clock::now();
+    size_t root = linkCut.findRoot(0)->key;
+    Node* minEdge = linkCut.getMinEdge(0);
+    size_t minWeight = minEdge->edgeWeight;
+    linkCut.removeWeightInPath(minWeight, 0);
+    size_t cutCount = 0;
+    while(linkCut.getEdgeWeight((minEdge = linkCut.getMinEdge(0))->key) == 0) {
+        linkCut.cut(minEdge->key, minEdge->key + 1);
+        linkCut.setWeight(minEdge->key, INF);
+        ++cutCount;
+    }
+    const size_t queries = 1000;
+    for(size_t i = 0;i < queries; ++i) {
+        linkCut.getEdgeWeight(random() % length);
+        linkCut.findRoot(random() % length);
+    }
+    double querySeconds = secondsSince(startTime);
     
+    struct rlimit stackLimit;
+    getrlimit(RLIMIT_STACK, &stackLimit);
+    cout << "deep path of " << length << " vertices: links " << linkSeconds * 1000 << " ms, root " << root
+         << ", min edge " << minWeight << " cut " << cutCount << " times, " << queries << " random weight and root queries, "
+         << querySeconds * 1000 << " ms in all, stack limit " << stackLimit.rlim_cur / 1024 << " KB, peak memory "
+         << peakMemoryKilobytes() / 1024 << " MB" << endl;
+}
+
+//random links of a tree root under a vertex of another tree, cuts of a vertex from its parent and the blocking
+//flow query (root, path minimum, weight removal) from random vertices; returns a checksum of the answers
+template <class DynamicTree>
+size_t runLinkCutWorkload(DynamicTree& linkCut, size_t sizeVert, size_t operations, unsigned seed, double& seconds) {
+    std::mt19937_64 random(seed);
+    vector <size_t> parent(sizeVert, sizeVert);
+    size_t checksum = 0;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    for(size_t i = 0;i < sizeVert; ++i) {
+        linkCut.setWeight(i, INF);
+    }
+    for(size_t i = 0;i < operations; ++i) {
+        size_t vertex = random() % sizeVert;
+        size_t kind = random() % 4;
+        if(kind < 2) {
+            size_t root = linkCut.findRoot(vertex)->key;
+            size_t other = random() % sizeVert;
+            if(linkCut.findRoot(other)->key != root) {
+                linkCut.setWeight(root, random() % 1000000 + 1000);
+                linkCut.link(root, other);
+                parent[root] = other;
+            }
+        } else if(kind == 2) {
+            if(parent[vertex] != sizeVert) {
+                linkCut.cut(vertex, parent[vertex]);
+                checksum += linkCut.getEdgeWeight(vertex);
+                linkCut.setWeight(vertex, INF);
+                parent[vertex] = sizeVert;
+            }
+        } else if(parent[vertex] != sizeVert) {
+            //like in the blocking flow, a path has at least one finite edge whenever its minimum is asked for
+            checksum += linkCut.findRoot(vertex)->key;
+            size_t minWeight = linkCut.getMinEdge(vertex)->edgeWeight;
+            checksum += minWeight;
+            linkCut.removeWeightInPath(minWeight / 2, vertex);
+        }
     }
+    seconds = secondsSince(startTime);
+    return checksum;
+}
 
-//**********************************************************************************************
+//rotations per second of AccessLinkCutTree: a deep random tree over shuffled vertex numbers, every vertex hangs
+//a few vertices below its predecessor, then roots of random vertices
+void benchmarkRotations(size_t sizeVert, unsigned seed) {
+    std::mt19937_64 random(seed);
+    vector <size_t> order(sizeVert);
+    for(size_t i = 0;i < sizeVert; ++i) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), random);
+    AccessLinkCutTree linkCut(sizeVert);
+    for(size_t i = 1;i < sizeVert; ++i) {
+        linkCut.setWeight(order[i], random() % 1000000 + 1);
+        linkCut.link(order[i], order[i - 1 - random() % min(i, (size_t)8)]);
+    }
+    linkCut.rotationCount = 0;
+    const size_t queries = 2000000;
+    size_t checksum = 0;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    for(size_t i = 0;i < queries; ++i) {
+        checksum += linkCut.findRoot(random() % sizeVert)->key;
+    }
+    double seconds = secondsSince(startTime);
+    cout << "rotations, " << sizeVert << " vertices: " << linkCut.rotationCount / seconds / 1e6 << "M rotations/s, "
+         << linkCut.rotationCount / queries << " per root query, " << sizeof(LinkCutNode) << " byte vertices, "
+         << linkCut.memoryBytes() / sizeVert << " bytes per vertex in all (root " << checksum / queries << ")" << endl;
+}
 
-void solveDinicMaxFlow();
-void linkCutTest();
+//phases that clear the forest and grow one short path through random vertices, like blocking flows touching
+//a small region of a big graph; returns seconds per phase
+template <class DynamicTree>
+double runPhaseResets(DynamicTree& linkCut, size_t sizeVert, size_t phases, size_t pathLength, unsigned seed, size_t& checksum) {
+    std::mt19937_64 random(seed);
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    for(size_t phase = 0;phase < phases; ++phase) {
+        linkCut.clearTrees();
+        size_t first = random() % sizeVert;
+        size_t top = first;
+        for(size_t i = 0;i < pathLength; ++i) {
+            size_t next = random() % sizeVert;
+            if(next != top && linkCut.findRoot(next)->key == next) {
+                linkCut.setWeight(top, random() % 1000000 + 1);
+                linkCut.link(top, next);
+                top = next;
+            }
+        }
+        linkCut.setWeight(top, INF);
+        linkCut.findRoot(first);
+        checksum += linkCut.getMinEdge(first)->edgeWeight;
+    }
+    return secondsSince(startTime) / phases;
+}
 
-int main() {
-    ios_base::sync_with_stdio(false);
-    freopen("input.txt", "r", stdin);
-    //freopen("output.txt", "w", stdout);
-    //while(1) {
-    solveDinicMaxFlow();
-    //}
-    return 0;
+void benchmarkPhaseReset(size_t sizeVert, size_t phases, size_t pathLength) {
+    size_t checksum[2] = {0, 0};
+    AccessLinkCutTree accessTree(sizeVert);
+    double accessSeconds = runPhaseResets(accessTree, sizeVert, phases, pathLength, 23, checksum[0]);
+    LinkCutTree splitTree(sizeVert);
+    double splitSeconds = runPhaseResets(splitTree, sizeVert, phases, pathLength, 23, checksum[1]);
+    cout << "phase reset, " << sizeVert << " vertices, " << pathLength << " vertex paths: access " << accessSeconds * 1e6
+         << " us per phase, split and merge " << splitSeconds * 1e6 << " us per phase"
+         << (checksum[0] == checksum[1] ? "" : " (CHECKSUM MISMATCH)") << endl;
 }
 
-void solveDinicMaxFlow() {
+//both link-cut tree backends on the random workload and under Dinic, with the rotation throughput and the memory
+//per vertex of the node pool of AccessLinkCutTree (a split and merge vertex is a Node and its own SplayTree)
+void benchmarkLinkCutBackends() {
+    benchmarkPhaseReset(100000, 2000, 100);
+    benchmarkPhaseReset(10000000, 30, 100);
+    for(size_t sizeVert = 10000;sizeVert <= 10000000; sizeVert *= 10) {
+        benchmarkRotations(sizeVert, 22);
+    }
+    for(size_t sizeVert = 1000;sizeVert <= 1000000; sizeVert *= 10) {
+        double seconds[2];
+        size_t checksum[2];
+        const size_t operations = 2000000;
+        AccessLinkCutTree accessTree(sizeVert);
+        checksum[0] = runLinkCutWorkload(accessTree, sizeVert, operations, 21, seconds[0]);
+        LinkCutTree splitTree(sizeVert);
+        checksum[1] = runLinkCutWorkload(splitTree, sizeVert, operations, 21, seconds[1]);
+        cout << "link-cut workload, " << sizeVert << " vertices, " << operations << " operations: access " << seconds[0] * 1000
+             << " ms (" << accessTree.rotationCount / seconds[0] / 1e6 << "M rotations/s, " << accessTree.memoryBytes() / sizeVert
+             << " bytes per vertex), split and merge " << seconds[1] * 1000 << " ms (" << sizeof(Node) + sizeof(SplayTree)
+             << " bytes per vertex and a SplayTree allocation), access faster by " << seconds[1] / seconds[0]
+             << (checksum[0] == checksum[1] ? "" : " (CHECKSUM MISMATCH)") << endl;
+    }
+    
+    Graph* graphs[4] = {generateRandomGraph(100000, 1000000, 1000, 4), generateRandomGraph(20000, 40000, 1000, 9),
+                        generateWideCapacityGrid(100, 100, 7), generateBroomGraph(20000, 20000)};
+    const char* names[4] = {"random 100K x 1M", "random 20K x 40K", "100 x 100 grid", "broom"};
+    for(int g = 0;g < 4; ++g) {
+        Graph* graph = graphs[g];
+        LinkCutBlockFlowFinder accessBlockFlowFinder(graph->sizeVert, 0, graph->sizeVert - 1);
+        SplitLinkCutBlockFlowFinder splitBlockFlowFinder(graph->sizeVert, 0, graph->sizeVert - 1);
+        BlockFlowFinder* blockFlowFinders[2] = {&accessBlockFlowFinder, &splitBlockFlowFinder};
+        Network network(graph, 0, graph->sizeVert - 1);
+        double seconds[2];
+        CapacityType maxFlow[2];
+        for(int i = 0;i < 2; ++i) {
+            DinicFlowFinder dinicFlowFinder(blockFlowFinders[i]);
+            network.reset(0, graph->sizeVert - 1);
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            network.getMaxFlow(dinicFlowFinder);
+            seconds[i] = secondsSince(startTime);
+            maxFlow[i] = network.maxFlow;
+        }
+        cout << "Dinic on " << names[g] << ": access " << seconds[0] * 1000 << " ms, split and merge " << seconds[1] * 1000
+             << " ms, access faster by " << seconds[1] / seconds[0] << (maxFlow[0] == maxFlow[1] ? "" : " (FLOW MISMATCH)") << endl;
+    }
+}
 
+//benchmarks that build all their graphs themselves, false if name isn't one of them
+bool runGeneratedBenchmark(const string& name, ThreadPool& pool) {
+    if(name == "unit-capacity") {
+        benchmarkUnitCapacity(generateBipartiteGraph(1000000, 1000000, 5, 1, 15), "bipartite 1M + 1M, degree 5");
+        benchmarkUnitCapacity(generateBipartiteGraph(200000, 100000, 20, 1, 16), "bipartite 200K + 100K, degree 20");
+        benchmarkUnitCapacity(generateBipartiteGraph(500000, 500000, 3, 7, 17), "bipartite 500K + 500K, degree 3, capacity 7");
+        benchmarkUnitCapacity(generateRandomGraph(1000000, 10000000, 1, 4), "random 1M x 10M");
+        benchmarkUnitCapacity(generateRandomGraph(100000, 2000000, 1, 18), "random 100K x 2M");
+    } else if(name == "link-cut") {
+        benchmarkLinkCutBackends();
+    } else if(name == "deep-path") {
+        benchmarkDeepPath(1000000, 19);
+        benchmarkDeepPath(4000000, 20);
+    } else if(name == "flow-write") {
+        benchmarkFlowWrite(pool);
+    } else {
+        return false;
+    }
+    return true;
+}
 
+int runBenchmark(const string& name, const char* path, size_t threadCount) {
+    ThreadPool pool(threadCount);
+    if(name == "push-relabel-check") {
+        return checkParallelPushRelabel(2000, 4, 24) ? 1 : 0;
+    }
+    if(name == "parser-check") {
+        return checkEdgeListParser() ? 1 : 0;
+    }
+    if(runGeneratedBenchmark(name, pool)) {
+        return 0; //the input file isn't needed, so it isn't loaded either
+    }
+    Graph* graph = loadGraphFile(path, nullptr, &pool);
+    if(!graph) {
+        return 1;
+    }
     
-    long long vert, edge, to, from, capacity;
-    vector <DirectEdge> edgeList;// = *(new vector <DirectEdge>);
-    DirectEdge curEdge;
-    cin >> vert >> edge;
-    edgeList.resize(edge);
-    // scanf("%lld%lld",&vert,&edge);
-    for(int i = 0;i < edge;++i) {
-        cin >> to >> from >> capacity;
-        --to;
-        --from;
-        curEdge.start = to;
-        curEdge.finish = from;
-        curEdge.capacity = capacity;
-        edgeList[i] = curEdge;
-    }
-    
-    Graph* graph = new Graph(vert, edgeList);
-    LinkCutBlockFlowFinder linkCutBlockflowFinder(vert, 0, vert - 1);
-    DinicFlowFinder dinicFlowFinder(&linkCutBlockflowFinder);
-    Network network(graph, 0, vert - 1);
-    network.getMaxFlow(dinicFlowFinder);
-    cout << network.maxFlow << endl;
-    
-    // for(size_t i = 0;i < network.flow.size(); ++i) {
-    //     cout << network.flow[i] << endl;
-    // }
+    if(name == "bfs") {
+        benchmarkBfs(graph, path);
+        benchmarkBfs(generateRandomGraph(1000000, 10000000, 1000000000, 1), "random 1M x 10M");
+    } else if(name == "bfs-hybrid") {
+        benchmarkHybridBfs(graph, path, true);
+        benchmarkHybridBfs(generateRandomGraph(100000, 1000000, 1000, 4), "random 100K x 1M", true);
+        benchmarkHybridBfs(generateRandomGraph(1000000, 10000000, 1000000000, 1), "random 1M x 10M", false);
+    } else if(name == "bfs-parallel") {
+        benchmarkParallelBfs(graph, path);
+        benchmarkParallelBfs(generateRandomGraph(5000000, 50000000, 1000000000, 5), "random 5M x 50M");
+    } else if(name == "prune") {
+        benchmarkPruning(graph, path);
+        benchmarkPruning(generateRandomGraph(100000, 1000000, 1000, 4), "random 100K x 1M");
+    } else if(name == "scaling") {
+        benchmarkScaling(graph, path);
+        benchmarkScaling(generateRandomGraph(100000, 1000000, 1000000000, 4), "random 100K x 1M, capacities 1..1e9");
+        benchmarkScaling(generateWideCapacityGraph(100000, 1000000, 6), "random 100K x 1M, capacities 2^0..2^29");
+        benchmarkScaling(generateWideCapacityGrid(100, 100, 7), "100 x 100 grid, capacities 2^0..2^29");
+    } else if(name == "block-flow") {
+        benchmarkBlockFlow(graph, path);
+        for(size_t degree = 2;degree <= 512; degree *= 4) {
+            benchmarkBlockFlow(generateRandomGraph(20000, 20000 * degree, 1000, 9), "random");
+        }
+        benchmarkBlockFlow(generateWideCapacityGrid(100, 100, 7), "100 x 100 grid");
+        benchmarkBlockFlow(generateChainGraph(150), "150 chains");
+        benchmarkBlockFlow(generateBroomGraph(20000, 20000), "broom, 20000 long handle and 20000 bristles");
+    } else if(name == "push-relabel") {
+        benchmarkPushRelabel(graph, path);
+        benchmarkPushRelabel(generateRandomGraph(100000, 1000000, 1000, 4), "random 100K x 1M");
+        benchmarkPushRelabel(generateWideCapacityGraph(100000, 1000000, 6), "random 100K x 1M, capacities 2^0..2^29");
+        benchmarkPushRelabel(generateLayeredGraph(10, 1000, 50, 1000, 10), "10 layers of 1000 vertices, 50 edges each");
+        benchmarkPushRelabel(generateLayeredGraph(100, 200, 10, 1000, 11), "100 layers of 200 vertices, 10 edges each");
+        benchmarkPushRelabel(generateWideCapacityGrid(100, 100, 7), "100 x 100 grid");
+        benchmarkPushRelabel(generateBroomGraph(20000, 20000), "broom");
+    } else if(name == "push-relabel-parallel") {
+        checkParallelPushRelabel(2000, 4, 24);
+        benchmarkParallelPushRelabel(graph, path);
+        benchmarkParallelPushRelabel(generateRandomGraph(1000000, 10000000, 1000, 4), "random 1M x 10M");
+        benchmarkParallelPushRelabel(generateLayeredGraph(10, 10000, 50, 1000, 10), "10 layers of 10000 vertices, 50 edges each");
+        benchmarkParallelPushRelabel(generateWideCapacityGrid(300, 300, 7), "300 x 300 grid");
+    } else if(name == "boykov-kolmogorov") {
+        benchmarkBoykovKolmogorov(graph, path);
+        benchmarkBoykovKolmogorov(generateRandomGraph(100000, 1000000, 1000, 4), "random 100K x 1M");
+        benchmarkBoykovKolmogorov(generateWideCapacityGrid(100, 100, 7), "100 x 100 grid");
+        benchmarkBoykovKolmogorov(generateSegmentationGrid(512, 512, 12), "512 x 512 segmentation grid");
+        benchmarkBoykovKolmogorov(generateSegmentationGrid(1024, 1024, 13), "1024 x 1024 segmentation grid");
+        benchmarkBoykovKolmogorov(generateSegmentationGrid(4096, 4096, 14), "4096 x 4096 segmentation grid");
+    } else if(name == "pseudoflow") {
+        benchmarkPseudoflow(graph, path);
+        benchmarkPseudoflow(generateRandomGraph(100000, 1000000, 1000, 4), "random 100K x 1M");
+        benchmarkPseudoflow(generateWideCapacityGraph(100000, 1000000, 6), "random 100K x 1M, capacities 2^0..2^29");
+        benchmarkPseudoflow(generateLayeredGraph(10, 1000, 50, 1000, 10), "10 layers of 1000 vertices, 50 edges each");
+        benchmarkPseudoflow(generateWideCapacityGrid(100, 100, 7), "100 x 100 grid");
+        benchmarkPseudoflow(generateSegmentationGrid(512, 512, 12), "512 x 512 segmentation grid");
+        benchmarkPseudoflow(generateBroomGraph(20000, 20000), "broom");
+    } else if(name == "level-graph") {
+        benchmarkLevelGraph(graph, path);
+        benchmarkLevelGraph(generateRandomGraph(100000, 1000000, 1000, 4), "random 100K x 1M");
+        benchmarkLevelGraph(generateChainGraph(150), "150 chains");
+    } else {
+        delete graph;
+        cerr << "unknown benchmark " << name << endl;
+        return 1;
+    }
+    return 0;
 }